@@ -0,0 +1,302 @@
+#include "../mgl/mgl.hpp"
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Pico de memoria residente do processo, em MB
+static double peakMemoryMB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0.0;
+    return double(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+#ifdef __APPLE__
+    return double(usage.ru_maxrss) / (1024.0 * 1024.0); // bytes
+#else
+    return double(usage.ru_maxrss) / 1024.0; // KB
+#endif
+#endif
+}
+
+std::vector<CameraKey> orbitPath(float distance, float pitch) {
+    return { { 0.0f, pitch, distance }, { 360.0f, pitch, distance } };
+}
+
+std::vector<CameraKey> zoomPath(float from, float to, float pitch) {
+    return { { 0.0f, pitch, from }, { 45.0f, pitch * 0.5f, to }, { 90.0f, pitch, from } };
+}
+
+Benchmark::Benchmark(const std::vector<BenchmarkCase>& cases, int frames, int warmup)
+    : cases(cases), frames(frames), warmup(warmup) {
+    if (cases.empty() || frames < 1 || warmup < 0)
+        throw std::runtime_error("Invalid benchmark.");
+    // o Profiler so guarda as ultimas HISTORY amostras de cada serie
+    if (size_t(frames) > mgl::Profiler::HISTORY)
+        throw std::runtime_error("Too many benchmark frames per case.");
+}
+
+int Benchmark::getTotalFrames() const {
+    return int(cases.size()) * (warmup + frames);
+}
+
+bool Benchmark::beginFrame() {
+    frame++;
+    bool started = current < 0 || frame == warmup + frames;
+    if (started) {
+        if (current >= 0) finishCase();
+        current++;
+        frame = 0;
+        if (current >= int(cases.size())) throw std::runtime_error("Benchmark already finished.");
+    }
+    // os resultados GPU do caso anterior chegam durante o aquecimento
+    if (frame == warmup) mgl::Profiler::getInstance().clear();
+    return started;
+}
+
+void Benchmark::moveCamera(OrbitalCamera& camera) const {
+    const std::vector<CameraKey>& keys = cases[current].keys;
+    if (keys.empty()) return;
+    CameraKey key = keys[0];
+    if (keys.size() > 1) {
+        // o aquecimento fica parado no primeiro ponto
+        float t = frame < warmup ? 0.0f : float(frame - warmup) / float(glm::max(frames - 1, 1));
+        float position = t * float(keys.size() - 1);
+        size_t i = glm::min(size_t(position), keys.size() - 2);
+        float f = position - float(i);
+        key.yaw = glm::mix(keys[i].yaw, keys[i + 1].yaw, f);
+        key.pitch = glm::mix(keys[i].pitch, keys[i + 1].pitch, f);
+        key.distance = glm::mix(keys[i].distance, keys[i + 1].distance, f);
+    }
+    camera.rotation = glm::angleAxis(glm::radians(key.yaw), glm::vec3(0, 1, 0)) *
+                      glm::angleAxis(glm::radians(key.pitch), glm::vec3(1, 0, 0));
+    camera.distance = key.distance;
+}
+
+void Benchmark::setMetric(const std::string& name, double value) {
+    metrics[name] = value;
+}
+
+void Benchmark::finishCase() {
+    mgl::Profiler& profiler = mgl::Profiler::getInstance();
+    Result result;
+    result.config = cases[current];
+    result.frame = profiler.getStats("Frame");
+    for (const std::string& name : profiler.getScopeNames())
+        if (name != "Frame") result.cpu[name] = profiler.getStats(name);
+    for (const std::string& name : profiler.getGpuScopeNames())
+        result.gpu[name] = profiler.getGpuStats(name);
+    result.metrics.swap(metrics);
+    result.peakMemoryMB = peakMemoryMB();
+    results.push_back(result);
+}
+
+void Benchmark::finish() {
+    if (current >= 0 && results.size() == size_t(current)) finishCase();
+}
+
+////////////////////////////////////////////////////////////////////////// JSON
+
+static void writeString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+static void writeStats(std::ostream& out, const mgl::Profiler::Stats& stats) {
+    out << "{\"mean\":" << stats.Mean << ",\"p50\":" << stats.P50 << ",\"p95\":" << stats.P95
+        << ",\"p99\":" << stats.P99 << ",\"stddev\":" << stats.StdDev
+        << ",\"count\":" << stats.Count << "}";
+}
+
+static void writeStatsMap(std::ostream& out, const std::map<std::string, mgl::Profiler::Stats>& all) {
+    out << "{";
+    bool first = true;
+    for (const auto& entry : all) {
+        if (!first) out << ",";
+        first = false;
+        writeString(out, entry.first);
+        out << ":";
+        writeStats(out, entry.second);
+    }
+    out << "}";
+}
+
+// Um caso por linha; os tempos estao em milissegundos
+void Benchmark::writeJson(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) throw std::runtime_error("Cannot write " + filename);
+    file << std::fixed << std::setprecision(4);
+    file << "{\"frames\":" << frames << ",\"warmup\":" << warmup << ",\"cases\":[";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        file << (i ? ",\n" : "\n") << "{\"name\":";
+        writeString(file, r.config.name);
+        file << ",\"width\":" << r.config.width << ",\"height\":" << r.config.height
+             << ",\"particles\":" << r.config.particles << ",\"stones\":" << r.config.stones
+             << ",\"path\":";
+        writeString(file, r.config.path);
+        file << ",\"multi_draw\":" << (r.config.multiDraw ? "true" : "false")
+             << ",\"depth_prepass\":" << (r.config.depthPrepass ? "true" : "false")
+             << ",\"occlusion\":" << (r.config.occlusion ? "true" : "false")
+             << ",\"dynamic_resolution\":" << r.config.dynamicResolution
+             << ",\"frame\":";
+        writeStats(file, r.frame);
+        file << ",\"cpu\":";
+        writeStatsMap(file, r.cpu);
+        file << ",\"gpu\":";
+        writeStatsMap(file, r.gpu);
+        for (const auto& metric : r.metrics) {
+            file << ",";
+            writeString(file, metric.first);
+            file << ":" << metric.second;
+        }
+        file << ",\"peak_memory_mb\":" << r.peakMemoryMB << "}";
+    }
+    file << "\n]}\n";
+}
+
+// Leitura minima do formato de writeJson: cada caso comeca por "name" e o
+// primeiro "p95" depois de "frame" e o do tempo de frame
+static std::map<std::string, double> readBaseline(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) throw std::runtime_error("Cannot read " + filename);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string text = buffer.str();
+    std::map<std::string, double> p95;
+    size_t pos = 0;
+    while ((pos = text.find("{\"name\":\"", pos)) != std::string::npos) {
+        pos += 9;
+        size_t end = text.find('"', pos);
+        size_t frame = text.find("\"frame\":", end);
+        size_t value = text.find("\"p95\":", frame);
+        if (end == std::string::npos || frame == std::string::npos || value == std::string::npos) break;
+        p95[text.substr(pos, end - pos)] = atof(text.c_str() + value + 6);
+        pos = value;
+    }
+    return p95;
+}
+
+int Benchmark::compare(const std::string& baselineFile, double threshold, std::ostream& out) const {
+    std::map<std::string, double> baseline = readBaseline(baselineFile);
+    int regressions = 0;
+    out << std::fixed << std::setprecision(3);
+    out << "  case                     p95 (ms)  baseline    change\n";
+    for (const Result& r : results) {
+        out << "  " << std::left << std::setw(24) << r.config.name << std::right
+            << std::setw(9) << r.frame.P95;
+        auto it = baseline.find(r.config.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            out << "         -    (new)\n";
+            continue;
+        }
+        double change = r.frame.P95 / it->second - 1.0;
+        bool regressed = change > threshold;
+        if (regressed) regressions++;
+        out << std::setw(10) << it->second << std::setw(9) << std::showpos << change * 100.0
+            << std::noshowpos << "%" << (regressed ? "  REGRESSION" : "") << "\n";
+    }
+    out << std::defaultfloat;
+    return regressions;
+}
+
+//////////////////////////////////////////////////////////////// MICROBENCHMARKS
+
+Microbench::Microbench(double minTime, int repetitions)
+    : minTime(minTime), repetitions(repetitions) {
+    if (minTime <= 0.0 || repetitions < 1)
+        throw std::runtime_error("Invalid microbenchmark settings.");
+}
+
+void Microbench::add(const std::string& name, Function function) {
+    Case c;
+    c.name = name;
+    c.function = function;
+    cases.push_back(c);
+}
+
+void Microbench::setCounter(const std::string& name, const std::string& counter, double value) {
+    for (Case& c : cases) {
+        if (c.name == name) {
+            c.counters[counter] = value;
+            return;
+        }
+    }
+    throw std::runtime_error("Unknown microbenchmark " + name);
+}
+
+double Microbench::seconds(const Function& function, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    function(iterations);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Microbench::run(std::ostream& out) {
+    out << std::fixed << std::setprecision(1);
+    out << "  benchmark                           ns/iter          min          max  iterations\n";
+    for (Case& c : cases) {
+        // a primeira corrida tambem aquece caches e alocacoes
+        int iterations = 1;
+        double elapsed;
+        while ((elapsed = seconds(c.function, iterations)) < minTime && iterations < (1 << 30)) {
+            // salta logo para perto de minTime, com margem
+            double factor = elapsed > 0.0 ? minTime * 1.4 / elapsed : 10.0;
+            iterations = int(std::min(double(iterations) * std::min(std::max(factor, 2.0), 10.0),
+                                      double(1 << 30)));
+        }
+        std::vector<double> times;
+        for (int r = 0; r < repetitions; r++)
+            times.push_back(seconds(c.function, iterations) * 1e9 / iterations);
+        std::sort(times.begin(), times.end());
+        c.iterations = iterations;
+        c.median = times[times.size() / 2];
+        c.min = times.front();
+        c.max = times.back();
+        out << "  " << std::left << std::setw(30) << c.name << std::right << std::setw(14)
+            << c.median << std::setw(13) << c.min << std::setw(13) << c.max
+            << std::setw(12) << iterations << "\n";
+    }
+    out << std::defaultfloat;
+}
+
+void Microbench::writeJson(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) throw std::runtime_error("Cannot write " + filename);
+    file << std::fixed << std::setprecision(3);
+    file << "{\"context\":{\"repetitions\":" << repetitions << ",\"min_time\":" << minTime
+         << "},\"benchmarks\":[";
+    for (size_t i = 0; i < cases.size(); i++) {
+        const Case& c = cases[i];
+        file << (i ? ",\n" : "\n") << "{\"name\":";
+        writeString(file, c.name);
+        file << ",\"iterations\":" << c.iterations << ",\"real_time\":" << c.median
+             << ",\"min_time\":" << c.min << ",\"max_time\":" << c.max
+             << ",\"time_unit\":\"ns\"";
+        for (const auto& counter : c.counters) {
+            file << ",";
+            writeString(file, counter.first);
+            file << ":" << counter.second;
+        }
+        file << "}";
+    }
+    file << "\n]}\n";
+}
@@ -0,0 +1,126 @@
+// Benchmark.hpp
+#pragma once
+#include "../mgl/mgl.hpp"
+#include "OrbitalCamera.hpp"
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Ponto de um percurso de camara (graus e distancia ao centro da orbita)
+struct CameraKey {
+    float yaw, pitch, distance;
+};
+
+// Um caso corre um percurso de camara sobre a cena com parametros fixos.
+// Os keyframes sao interpolados linearmente ao longo dos frames medidos.
+struct BenchmarkCase {
+    std::string name;
+    int width = 800, height = 600;
+    int particles = 5000;
+    int stones = 12;
+    std::string path = "orbit";   // so para o relatorio
+    std::vector<CameraKey> keys;
+    bool multiDraw = true;
+    bool depthPrepass = false;
+    bool occlusion = false;
+    double dynamicResolution = 0.0; // alvo de GPU em ms (0 = resolucao fixa)
+};
+
+// Percursos predefinidos
+std::vector<CameraKey> orbitPath(float distance, float pitch);
+std::vector<CameraKey> zoomPath(float from, float to, float pitch);
+
+// Corre os casos em sequencia, um frame de cada vez (modo headless do Engine).
+// Cada caso tem 'warmup' frames que nao contam e depois 'frames' medidos: as
+// estatisticas do Profiler (frame, scopes CPU e GPU) sao limpas no inicio da
+// medicao e guardadas no fim. A app junta metricas proprias com setMetric.
+class Benchmark {
+public:
+    Benchmark(const std::vector<BenchmarkCase>& cases, int frames, int warmup);
+
+    int getTotalFrames() const;
+
+    // Avanca um frame; true quando comeca um caso novo (a app aplica-o)
+    bool beginFrame();
+    const BenchmarkCase& getCase() const { return cases[current]; }
+    // Ultimo frame medido do caso atual (altura de recolher metricas)
+    bool isLastFrame() const { return frame == warmup + frames - 1; }
+    // Coloca a camara no ponto do percurso deste frame
+    void moveCamera(OrbitalCamera& camera) const;
+    void setMetric(const std::string& name, double value);
+    // Guarda o ultimo caso; chamar depois de Engine::run()
+    void finish();
+
+    void writeJson(const std::string& filename) const;
+    // Compara o p95 do frame de cada caso com o de um ficheiro escrito por
+    // writeJson; devolve o numero de casos mais lentos que (1 + threshold) vezes
+    // o baseline. Casos sem baseline sao so listados.
+    int compare(const std::string& baselineFile, double threshold, std::ostream& out) const;
+
+private:
+    struct Result {
+        BenchmarkCase config;
+        mgl::Profiler::Stats frame;
+        std::map<std::string, mgl::Profiler::Stats> cpu, gpu;
+        std::map<std::string, double> metrics;
+        double peakMemoryMB = 0.0;
+    };
+
+    std::vector<BenchmarkCase> cases;
+    std::vector<Result> results;
+    std::map<std::string, double> metrics;
+    int frames, warmup;
+    int current = -1;
+    int frame = -1;
+
+    void finishCase();
+};
+
+// Impede o compilador de eliminar um calculo cujo resultado nao e usado
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const volatile void* sink;
+    sink = &value;
+#endif
+}
+
+// Microbenchmarks de funcoes isoladas, no estilo do Google Benchmark: cada
+// funcao recebe o numero de iteracoes a correr. As iteracoes duplicam ate uma
+// corrida durar pelo menos minTime segundos; o resultado e a mediana de
+// 'repetitions' corridas, em ns por iteracao. A preparacao que nao deve contar
+// fica fora da funcao (ou e paga uma vez e diluida pelas iteracoes).
+class Microbench {
+public:
+    typedef std::function<void(int iterations)> Function;
+
+    explicit Microbench(double minTime = 0.05, int repetitions = 5);
+
+    void add(const std::string& name, Function function);
+    // Valor extra de um caso (ex. draw calls), escrito no JSON como os
+    // user counters do Google Benchmark
+    void setCounter(const std::string& name, const std::string& counter, double value);
+    // Corre todos os casos e imprime uma tabela
+    void run(std::ostream& out);
+    // Formato JSON do Google Benchmark ("benchmarks": name, iterations, real_time)
+    void writeJson(const std::string& filename) const;
+
+private:
+    struct Case {
+        std::string name;
+        Function function;
+        int iterations = 0;
+        double median = 0.0, min = 0.0, max = 0.0; // ns por iteracao
+        std::map<std::string, double> counters;
+    };
+
+    std::vector<Case> cases;
+    double minTime;
+    int repetitions;
+
+    static double seconds(const Function& function, int iterations);
+};
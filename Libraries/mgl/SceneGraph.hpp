@@ -1,83 +1,1002 @@
 #pragma once
 #include "../mgl/mgl.hpp"
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <stdexcept>
 #include <vector>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+// Descricao de um no para o SceneGraph::addNode. No grafo os dados ficam
+// repartidos por componentes em arrays densos (Renderable e Material; a
+// transformacao e a hierarquia no TransformHierarchy) e cada passo so
+// percorre os arrays de que precisa.
 class SceneNode {
 public:
     mgl::Mesh* mesh = nullptr;
     mgl::ShaderProgram* shader = nullptr;
+    mgl::ProgramPipeline* pipeline = nullptr; // alternativa ao shader (programas separaveis)
+    // Variante INSTANCED da pipeline: usada quando varios nos partilham mesh e programa
+    mgl::ProgramPipeline* instancedPipeline = nullptr;
 
-    glm::mat4 modelMatrix = glm::mat4(1.0f); // local transform
-    glm::vec3 color = glm::vec3(1.0f);       // base color
+    glm::vec3 color = glm::vec3(1.0f); // base color
 
     // Material (Blinn-Phong)
     float ambientStrength = 0.1f;
     float specularStrength = 0.5f;
     float shininess = 32.0f;
 
-    std::vector<SceneNode*> children;
     int submeshIndex = -1; // -1 = draw all submeshes
+    bool transparent = false; // desenhado depois dos opacos, de tras para a frente
+};
 
-    SceneNode() = default;
+// Componente de material (Blinn-Phong) dos nos com mesh
+struct Material {
+    glm::vec3 color = glm::vec3(1.0f); // base color
+    float ambientStrength = 0.1f;
+    float specularStrength = 0.5f;
+    float shininess = 32.0f;
 
-    ~SceneNode() {
-        for (auto child : children) delete child;
+    // Ordem total para os ids de material da chave de ordenacao
+    bool operator<(const Material& o) const {
+        if (color.x != o.color.x) return color.x < o.color.x;
+        if (color.y != o.color.y) return color.y < o.color.y;
+        if (color.z != o.color.z) return color.z < o.color.z;
+        if (ambientStrength != o.ambientStrength) return ambientStrength < o.ambientStrength;
+        if (specularStrength != o.specularStrength) return specularStrength < o.specularStrength;
+        return shininess < o.shininess;
     }
+};
 
-    void addChild(SceneNode* child) {
-        children.push_back(child);
+// Componente com o que e preciso para desenhar (so os nos com mesh o tem)
+struct Renderable {
+    mgl::Mesh* mesh = nullptr;
+    mgl::ShaderProgram* shader = nullptr;
+    mgl::ProgramPipeline* pipeline = nullptr;
+    mgl::ProgramPipeline* instancedPipeline = nullptr;
+    int submeshIndex = -1;
+    bool transparent = false;
+
+    // Uniform slots (UniformTable do shader), resolvidos uma vez por shader
+    mgl::ShaderProgram* slotsVertex = nullptr;
+    mgl::ShaderProgram* slotsFragment = nullptr;
+    GLint modelSlot = -1, colorSlot = -1;
+    GLint ambientSlot = -1, specularSlot = -1, shininessSlot = -1;
+
+    //antes de desenhar, enviamos os dados ao shader - automatically handles matrices
+    void draw(const glm::mat4& worldMatrix, const Material& material) {
+        if (mesh && (shader || pipeline)) {
+            resolve();
+            bind();
+            setMaterial(material);
+            drawMesh(worldMatrix);
+        }
     }
 
-    //antes de desenhar, enviamos os dados ao shader - automatically handles matrices
-    void draw(const glm::mat4& parentMatrix) {
-        //transformao global cada no
-        glm::mat4 globalMatrix = parentMatrix * modelMatrix; 
+    // Passos separados para a RenderQueue saltar os binds e uploads repetidos
+    void resolve() {
+        // Com pipeline, a ModelMatrix vive no programa do vertex stage
+        // e o material no programa do fragment stage
+        mgl::ShaderProgram* vertexProgram = shader;
+        mgl::ShaderProgram* fragmentProgram = shader;
+        if (pipeline) {
+            vertexProgram = pipeline->getProgram(GL_VERTEX_SHADER_BIT);
+            fragmentProgram = pipeline->getProgram(GL_FRAGMENT_SHADER_BIT);
+        }
 
-        
-        if (mesh && shader) {
+        if (slotsVertex != vertexProgram || slotsFragment != fragmentProgram) {
+            resolveSlots(vertexProgram, fragmentProgram);
+        }
+    }
+
+    void bind() {
+        if (pipeline) {
+            pipeline->bind();
+        }
+        else {
             shader->bind();
+        }
+    }
+
+    void setMaterial(const Material& material) {
+        // Base color (enviar para o shader)
+        slotsFragment->setUniform(colorSlot, material.color);
+
+        // Material uniforms (enviar para o shader)
+        slotsFragment->setUniform(ambientSlot, material.ambientStrength);
+        slotsFragment->setUniform(specularSlot, material.specularStrength);
+        slotsFragment->setUniform(shininessSlot, material.shininess);
+    }
+
+    void drawMesh(const glm::mat4& worldMatrix) {
+        // Model matrix (enviar para o shader)
+        slotsVertex->setUniform(modelSlot, worldMatrix);
+
+        // Draw mesh
+        if (submeshIndex >= 0) {
+            mesh->draw(submeshIndex);
+        }
+        else {
+            mesh->draw();
+        }
+        // Sem unbind: o StateCache ignora o bind se o proximo no usar o mesmo programa
+    }
+
+private:
+    // Uniforms inexistentes ficam com slot -1 (ignorados pelo setUniform)
+    static GLint findSlot(const mgl::ShaderProgram* program, const char* name) {
+        for (size_t i = 0; i < program->UniformTable.size(); i++) {
+            if (program->UniformTable[i].name == name) return GLint(i);
+        }
+        return -1;
+    }
+
+    void resolveSlots(mgl::ShaderProgram* vertexProgram, mgl::ShaderProgram* fragmentProgram) {
+        slotsVertex = vertexProgram;
+        slotsFragment = fragmentProgram;
+        modelSlot = findSlot(vertexProgram, mgl::MODEL_MATRIX);
+        colorSlot = findSlot(fragmentProgram, "baseColor");
+        ambientSlot = findSlot(fragmentProgram, "ambientStrength");
+        specularSlot = findSlot(fragmentProgram, "specularStrength");
+        shininessSlot = findSlot(fragmentProgram, "shininess");
+    }
+};
+
+
+// Grafo de cena "achatado": os nos ficam num array contiguo por ordem topologica
+// (pai antes dos filhos) e as matrizes no TransformHierarchy. Cada frame so sao
+// recalculadas as world matrices de nos alterados (ou com um antecessor alterado).
+// Os nos vivem num mgl::Pool e sao referidos por handles: criar e remover nos
+// reutiliza slots livres sem alocar, e um handle de um no removido fica invalido.
+// O indice do slot e a entidade nos mgl::ComponentStore de Renderable e Material.
+class SceneGraph {
+private:
+    // Numero de filhos vivos (o pai esta no TransformHierarchy)
+    struct Entity {
+        unsigned int children = 0;
+    };
+
+public:
+    typedef mgl::Pool<Entity>::Handle Handle;
+
+    SceneGraph() = default;
+    SceneGraph(const SceneGraph&) = delete;
+    SceneGraph& operator=(const SceneGraph&) = delete;
+
+    ~SceneGraph() {
+        if (instanceBuffer) glDeleteBuffers(1, &instanceBuffer);
+        if (indirectInstanceBuffer) glDeleteBuffers(1, &indirectInstanceBuffer);
+        if (commandBuffer) glDeleteBuffers(1, &commandBuffer);
+    }
+
+    // Contadores do ultimo frame: binds feitos vs. draws (o resto foi poupado)
+    struct Stats {
+        unsigned int draws = 0;
+        unsigned int instances = 0; // nos desenhados por draws instanciados
+        unsigned int indirectCommands = 0; // comandos dos glMultiDrawElementsIndirect
+        unsigned int programBinds = 0;
+        unsigned int meshBinds = 0;
+        unsigned int materialUploads = 0;
+        unsigned int nodesTested = 0; // testes de esfera contra o frustum
+        unsigned int nodesCulled = 0; // nos com mesh rejeitados (eles ou um antecessor)
+        unsigned int nodesDrawn = 0;
+        unsigned int nodesOccluded = 0; // dentro do frustum mas escondidos pelo Hi-Z (frames de atraso)
+        unsigned int depthDraws = 0; // draws do depth pre-pass
+    };
+
+    // O pai tem de estar vivo (um handle vazio cria uma raiz); o slot escolhido
+    // fica sempre depois do do pai. Os ids de ordenacao (programa, mesh,
+    // material) sao calculados aqui.
+    Handle addNode(const SceneNode& node, const glm::mat4& modelMatrix, Handle parent = Handle()) {
+        int parentIndex = NO_PARENT;
+        if (parent != Handle()) {
+            if (!nodes.isValid(parent)) throw std::runtime_error("Parent node no longer exists.");
+            parentIndex = int(parent.Index);
+        }
+        Handle handle = nodes.createAfter(Entity(), parent.Index);
+        size_t index = handle.Index;
+        if (index == transforms.size()) {
+            transforms.add(modelMatrix, parentIndex);
+            sortIds.emplace_back();
+        } else {
+            transforms.reset(int(index), modelMatrix, parentIndex);
+            if (index < occluded.size()) occluded[index] = 0;
+        }
+        if (parentIndex != NO_PARENT) nodes[parentIndex].children++;
 
-            // Model matrix (enviar para o shader)
-            GLint modelId = shader->Uniforms[mgl::MODEL_MATRIX].index;
-            if (modelId >= 0) {
-                glUniformMatrix4fv(
-                    modelId, 1, GL_FALSE,
-                    glm::value_ptr(globalMatrix)
-                );
+        if (node.mesh) {
+            Renderable& renderable = renderables.add(handle.Index);
+            renderable.mesh = node.mesh;
+            renderable.shader = node.shader;
+            renderable.pipeline = node.pipeline;
+            renderable.instancedPipeline = node.instancedPipeline;
+            renderable.submeshIndex = node.submeshIndex;
+            renderable.transparent = node.transparent;
+            Material material;
+            material.color = node.color;
+            material.ambientStrength = node.ambientStrength;
+            material.specularStrength = node.specularStrength;
+            material.shininess = node.shininess;
+            materials.add(handle.Index, material);
+            acquireSortIds(index);
+        }
+        commandsDirty = true;
+        boundsDirty = true;
+        return handle;
+    }
+
+    // Remove o no e todos os descendentes; O(1) para folhas. Os filhos estao
+    // sempre em slots depois do pai, por isso basta uma passagem para a frente.
+    bool removeNode(Handle handle) {
+        if (!nodes.isValid(handle)) return false;
+        size_t first = handle.Index;
+        if (nodes[first].children == 0) {
+            destroySlot(first);
+        } else {
+            size_t n = nodes.getSlotCount();
+            removing.assign(n, 0);
+            removing[first] = 1;
+            for (size_t i = first + 1; i < n; i++) {
+                int parent = transforms.getParent(int(i));
+                if (parent != NO_PARENT && removing[parent] && nodes.isAlive(i)) removing[i] = 1;
+            }
+            // do fim para o inicio: os slots livres saem do pool por ordem crescente
+            for (size_t i = n; i-- > first; ) {
+                if (removing[i]) destroySlot(i);
+            }
+        }
+        commandsDirty = true;
+        boundsDirty = true;
+        return true;
+    }
+
+    // Remove todos os nos de uma vez; a memoria fica reservada para os seguintes.
+    void clear() {
+        nodes.clear();
+        renderables.clear();
+        materials.clear();
+        transforms.clear();
+        sortIds.clear();
+        programIds.clear();
+        meshIds.clear();
+        materialIds.clear();
+        visible.clear();
+        occluded.clear();
+        commandsDirty = true;
+        boundsDirty = true;
+    }
+
+    bool isValid(Handle handle) const { return nodes.isValid(handle); }
+
+    // Devolve nullptr se o no ja foi removido ou nao tem mesh
+    const Renderable* getRenderable(Handle handle) const {
+        return nodes.isValid(handle) ? renderables.get(handle.Index) : nullptr;
+    }
+    // Mudar mesh, submesh, shader ou pipeline muda os ids de ordenacao e os
+    // comandos indirectos: os ids sao readquiridos (antes de libertar os antigos,
+    // como no setMaterial) e os comandos reconstruidos no proximo draw.
+    void setRenderable(Handle handle, const Renderable& renderable) {
+        if (!nodes.isValid(handle) || !renderables.has(handle.Index)) return;
+        SortIds previous = sortIds[handle.Index];
+        *renderables.get(handle.Index) = renderable;
+        acquireSortIds(handle.Index);
+        programIds.release(previous.program);
+        meshIds.release(previous.mesh);
+        materialIds.release(previous.material);
+        commandsDirty = true;
+        boundsDirty = true;
+    }
+    const Material* getMaterial(Handle handle) const {
+        return nodes.isValid(handle) ? materials.get(handle.Index) : nullptr;
+    }
+    void setMaterial(Handle handle, const Material& material) {
+        if (!nodes.isValid(handle) || !materials.has(handle.Index)) return;
+        *materials.get(handle.Index) = material;
+        // adquirir antes de libertar: o id mantem-se se o material for igual
+        SortIds& ids = sortIds[handle.Index];
+        unsigned int previous = ids.material;
+        ids.material = materialIds.acquire(material);
+        materialIds.release(previous);
+        commandsDirty = true;
+    }
+    size_t size() const { return nodes.size(); }
+    size_t getRenderableCount() const { return renderables.size(); }
+    // Slots do pool de nos (vivos e livres) e vezes que o array de slots cresceu:
+    // criar e remover nos em regime estavel nao os deve alterar
+    size_t getSlotCount() const { return nodes.getSlotCount(); }
+    size_t getGrowthCount() const { return nodes.getGrowthCount(); }
+
+    void setModelMatrix(Handle handle, const glm::mat4& modelMatrix) {
+        if (nodes.isValid(handle)) transforms.setLocal(int(handle.Index), modelMatrix);
+    }
+    const glm::mat4& getModelMatrix(Handle handle) const { return transforms.getLocal(int(handle.Index)); }
+    const glm::mat4& getWorldMatrix(Handle handle) const { return transforms.getWorld(int(handle.Index)); }
+
+    const Stats& getStats() const { return stats; }
+
+    // Nos opacos com instancedPipeline passam a ser desenhados com um
+    // glMultiDrawElementsIndirect por (programa, mesh); os restantes vao pela fila
+    void setMultiDrawIndirect(bool enabled) {
+        if (enabled == multiDraw) return;
+        multiDraw = enabled;
+        occlusionReset = true;
+        commandsDirty = true;
+    }
+    bool isMultiDrawIndirect() const { return multiDraw; }
+
+    // Raio em world space contra a BVH dos nos (do ultimo draw) e depois contra
+    // a BVH de triangulos da mesh; devolve o no mais proximo atingido ou um
+    // handle invalido. distance e a distancia maxima e fica com a do ponto atingido.
+    Handle pick(const mgl::Bvh::Ray& ray, float& distance) {
+        int hit = nodeBvh.raycast(ray, [this](unsigned int primitive, const mgl::Bvh::Ray& r,
+                                              float maxDistance) {
+            unsigned int index = bvhNodes[primitive];
+            const Renderable& node = *renderables.get(index);
+            // o parametro t nao muda ao passar o raio para model space
+            glm::mat4 inverse = glm::inverse(transforms.getWorld(int(index)));
+            mgl::Bvh::Ray local = { glm::vec3(inverse * glm::vec4(r.Origin, 1.0f)),
+                                    glm::vec3(inverse * glm::vec4(r.Direction, 0.0f)) };
+            float t = maxDistance;
+            return node.mesh->intersect(local, t, node.submeshIndex) ? t : -1.0f;
+        }, distance);
+        return hit < 0 ? Handle() : nodes.getHandle(bvhNodes[hit]);
+    }
+
+    // Depth pre-pass: os nos opacos cuja pipeline tem uma versao so com o vertex
+    // stage (ShaderVariants::getDepthPipeline) sao primeiro desenhados so em depth e
+    // depois sombreados sem escrever depth. Com o mesmo programa de vertices a
+    // profundidade e identica e o GL_LEQUAL do Engine so deixa passar o fragmento
+    // visivel: os fragment shaders procedurais deixam de pagar o overdraw.
+    void setDepthPipeline(const mgl::ProgramPipeline* pipeline, mgl::ProgramPipeline* depthPipeline) {
+        depthPipelines[pipeline] = depthPipeline;
+    }
+    void setDepthPrepass(bool enabled) { depthPrepass = enabled; }
+    bool isDepthPrepass() const { return depthPrepass; }
+
+    // Com o culling desligado todos os nos sao desenhados (para comparar)
+    void setCulling(bool enabled) { culling = enabled; }
+    bool isCulling() const { return culling; }
+
+    // Occlusion culling em duas fases (nullptr desliga): desenha os nos opacos
+    // visiveis no ultimo teste, constroi a piramide Hi-Z com essa profundidade,
+    // testa todas as caixas e desenha o que passou a ser visivel (e os transparentes).
+    // Com multi-draw indirect o compute shader escreve o instanceCount de cada no
+    // (um comando por no) e o CPU nao espera pelo GPU. Os nos desenhados pela fila
+    // nunca sao escondidos: o resultado lido pelo CPU, alguns frames atrasado, so
+    // decide se sao desenhados antes ou depois da piramide.
+    void setOcclusionCuller(mgl::OcclusionCuller* culler) {
+        if (culler == occlusion) return;
+        occlusion = culler;
+        occlusionReset = true;
+        commandsDirty = true;
+    }
+    bool isOcclusionCulling() const { return occlusion != nullptr; }
+
+    // Depois do frustum culling cada no visivel gera um draw item, a fila e ordenada e
+    // o estado so muda quando o programa, a mesh ou o material mudam. Nos opacos seguidos
+    // com a mesma mesh e programa (e com instancedPipeline) sao um so draw instanciado.
+    void draw(const glm::vec3& viewPos, const glm::mat4& viewProjection) {
+        bool moved = transforms.update() > 0;
+
+        stats = Stats();
+        bool rebuilt = boundsDirty;
+        if (moved || boundsDirty) updateBounds();
+        frustum.update(viewProjection);
+        bool visibilityChanged = cull(frustum);
+
+        size_t n = nodes.getSlotCount();
+        if (!occlusion) {
+            drawMask = visible;
+            submit(viewPos, moved || visibilityChanged);
+            return;
+        }
+
+        if (multiDraw) {
+            // antes do culler: o upload dos comandos repoe os instanceCount
+            if (commandsDirty) buildCommands();
+            else if (moved) uploadIndirectInstances();
+        }
+        cullBoxes.resize(bvhNodes.size());
+        for (size_t k = 0; k < bvhNodes.size(); k++) {
+            unsigned int i = bvhNodes[k];
+            mgl::OcclusionCuller::Box& box = cullBoxes[k];
+            box.Min = glm::vec4(nodeBoxes[k].Min, 1.0f);
+            box.Max = glm::vec4(nodeBoxes[k].Max, 1.0f);
+            NodeRange range = { 0, 0 };
+            if (usesIndirect(*renderables.get(i))) range = commandRanges[i];
+            box.FirstCommand = range.first;
+            box.CommandCount = range.last - range.first;
+            box.InFrustum = visible[i];
+            box.Padding = 0;
+        }
+        // a ordem das caixas muda com a estrutura da cena (BVH reconstruida)
+        bool reset = occlusionReset || rebuilt;
+        occlusion->setBoxes(cullBoxes, reset);
+        occlusionReset = false;
+        if (reset) occluded.assign(n, 0);
+        else occluded.resize(n, 0);
+        if (occlusion->getVisibility(boxVisible)) {
+            for (size_t k = 0; k < bvhNodes.size(); k++) {
+                occluded[bvhNodes[k]] = !boxVisible[k];
             }
+        }
 
-            // Base color (enviar para o shader)
-            GLint colorId = shader->Uniforms["baseColor"].index;
-            if (colorId >= 0) {
-                glUniform3fv(colorId, 1, glm::value_ptr(color));
+        // fase 1: o GPU seleciona os comandos dos nos visiveis no ultimo teste; os
+        // nos opacos da fila usam o resultado lido pelo CPU, atrasado (os novos
+        // contam como visiveis)
+        GLuint commands = multiDraw ? commandBuffer : 0;
+        occlusion->selectPrevious(commands);
+        drawMask.assign(n, 0);
+        for (size_t k = 0; k < renderables.size(); k++) {
+            unsigned int i = renderables.getEntity(k);
+            const Renderable& node = renderables[k];
+            if (!visible[i] || occluded[i]) continue;
+            if (usesIndirect(node)) {
+                // so o GPU sabe quantos: estimativa com o resultado atrasado
+                stats.instances++;
+                stats.nodesDrawn++;
             }
+            else drawMask[i] = !node.transparent;
+        }
+        submit(viewPos, false);
+
+        // fase 2: o GPU seleciona os comandos dos nos que passaram a ser visiveis.
+        // O CPU nao conhece o teste deste frame: um "oculto" atrasado so quer dizer
+        // "ainda nao desenhado", por isso os nos da fila que ficaram de fora na fase 1
+        // sao desenhados agora (ja com a profundidade dos oclusores), e os transparentes
+        for (size_t k = 0; k < renderables.size(); k++) {
+            unsigned int i = renderables.getEntity(k);
+            const Renderable& node = renderables[k];
+            drawMask[i] = visible[i] && !usesIndirect(node) && (node.transparent || occluded[i]);
+        }
+        occlusion->buildPyramid();
+        occlusion->selectVisible(commands, viewProjection);
+        // so o que um teste escondeu de facto (comandos indirectos, contados no GPU)
+        stats.nodesOccluded = occlusion->getHidden();
+        submit(viewPos, false);
+    }
 
-            // Material uniforms (enviar para o shader)
-            GLint ambId = shader->Uniforms["ambientStrength"].index;
-            GLint specId = shader->Uniforms["specularStrength"].index;
-            GLint shinId = shader->Uniforms["shininess"].index;
+private:
+    // Desenha os nos com drawMask[i] != 0
+    void submit(const glm::vec3& viewPos, bool maskChanged) {
+        if (multiDraw) {
+            // os comandos so mudam com a cena; as instancias quando algo se move
+            // ou o que e desenhado muda
+            if (commandsDirty) buildCommands();
+            else if (maskChanged) uploadIndirectInstances();
+        }
 
-            if (ambId >= 0) glUniform1f(ambId, ambientStrength);
-            if (specId >= 0) glUniform1f(specId, specularStrength);
-            if (shinId >= 0) glUniform1f(shinId, shininess);
+        queue.clear();
+        for (size_t k = 0; k < renderables.size(); k++) {
+            const Renderable& node = renderables[k];
+            unsigned int i = renderables.getEntity(k);
+            if (!(node.shader || node.pipeline) || usesIndirect(node)) continue;
+            if (!drawMask[i]) continue;
+
+            // distancia a camara em [0,1)
+            float distance = glm::length(glm::vec3(transforms.getWorld(int(i))[3]) - viewPos);
+            float depth = distance / (distance + 1.0f);
+            mgl::RenderQueue::Pass pass = node.transparent ? mgl::RenderQueue::PASS_TRANSPARENT
+                                                           : mgl::RenderQueue::PASS_OPAQUE;
+            const SortIds& ids = sortIds[i];
+            queue.push(mgl::RenderQueue::makeKey(pass, ids.program, ids.mesh, ids.material, depth),
+                       unsigned(i));
+        }
+        queue.sort();
 
-            // Draw mesh
-            if (submeshIndex >= 0) {
-                mesh->draw(submeshIndex);
+        buildBatches();
+
+        if (depthPrepass) drawDepth();
+
+        const void* boundProgram = nullptr;
+        if (multiDraw) drawIndirect(boundProgram, false);
+
+        mgl::StateCache& cache = mgl::StateCache::getInstance();
+        int boundMesh = -1, boundMaterial = -1;
+        bool blending = false;
+        for (const Batch& batch : batches) {
+            unsigned int index = queue[batch.first].index;
+            Renderable& node = *renderables.get(index);
+            const SortIds& ids = sortIds[index];
+
+            if (node.transparent && !blending) {
+                cache.setEnabled(GL_BLEND, true);
+                cache.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                cache.depthMask(GL_FALSE);
+                blending = true;
+            }
+            else if (!node.transparent) {
+                // a profundidade ja esta no depth buffer: so passa o fragmento visivel
+                cache.depthMask(depthPipelineOf(batch) ? GL_FALSE : GL_TRUE);
+            }
+            if (boundMesh != int(ids.mesh)) {
+                boundMesh = int(ids.mesh);
+                stats.meshBinds++;
+            }
+
+            if (batch.count > 1) {
+                // material e ModelMatrix vem do instance buffer
+                if (boundProgram != node.instancedPipeline) {
+                    node.instancedPipeline->bind();
+                    boundProgram = node.instancedPipeline;
+                    stats.programBinds++;
+                }
+                node.mesh->setInstanceBuffer(instanceBuffer);
+                node.mesh->drawInstanced(node.submeshIndex, batch.count, batch.baseInstance);
+                stats.instances += batch.count;
             }
             else {
-                mesh->draw();
+                const void* program = node.pipeline ? (const void*)node.pipeline
+                                                    : (const void*)node.shader;
+                node.resolve();
+                if (boundProgram != program) {
+                    node.bind();
+                    boundProgram = program;
+                    boundMaterial = -1;
+                    stats.programBinds++;
+                }
+                if (boundMaterial != int(ids.material)) {
+                    node.setMaterial(*materials.get(index));
+                    boundMaterial = int(ids.material);
+                    stats.materialUploads++;
+                }
+                node.drawMesh(transforms.getWorld(int(index)));
+            }
+            stats.draws++;
+            stats.nodesDrawn += batch.count;
+        }
+        if (blending) {
+            cache.setEnabled(GL_BLEND, false);
+        }
+        cache.depthMask(GL_TRUE);
+    }
+
+    struct SortIds {
+        unsigned int program, mesh, material;
+    };
+
+    // Itens [first, first + count) da fila; count > 1 = draw instanciado
+    struct Batch {
+        unsigned int first, count, baseInstance;
+    };
+
+    // Nos [first, last) de indirectNodes desenhados por um comando indirecto
+    struct NodeRange {
+        unsigned int first, last;
+    };
+
+    // Comandos [firstCommand, firstCommand + commandCount) de um glMultiDrawElementsIndirect
+    struct IndirectGroup {
+        mgl::ProgramPipeline* pipeline;
+        mgl::Mesh* mesh;
+        unsigned int firstCommand, commandCount, instances;
+    };
+
+    // Esfera envolvente do no (mesh na world matrix) e da subarvore (o no e
+    // todos os descendentes); raio negativo = sem geometria.
+    // A BVH dos nos e reconstruida quando a cena muda e so reajustada quando algo se move.
+    void updateBounds() {
+        size_t n = nodes.getSlotCount();
+        nodeSpheres.assign(n, glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+        if (boundsDirty) bvhNodes.clear();
+        nodeBoxes.clear();
+        for (size_t k = 0; k < renderables.size(); k++) {
+            const Renderable& node = renderables[k];
+            unsigned int i = renderables.getEntity(k);
+            const mgl::Mesh::Bounds& bounds = node.mesh->getBounds(node.submeshIndex);
+            const glm::mat4& world = transforms.getWorld(int(i));
+            mgl::Bvh::Aabb box = { bounds.Min, bounds.Max };
+            nodeBoxes.push_back(mgl::Bvh::transform(box, world));
+            if (boundsDirty) bvhNodes.push_back(unsigned(i));
+            float scale = std::max(glm::length(glm::vec3(world[0])),
+                          std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+            nodeSpheres[i] = glm::vec4(glm::vec3(world * glm::vec4(bounds.Center, 1.0f)),
+                                       bounds.Radius * scale);
+        }
+        // filhos depois dos pais: percorrer ao contrario junta cada subarvore completa no pai
+        subtreeSpheres = nodeSpheres;
+        for (size_t i = n; i-- > 0;) {
+            int parent = transforms.getParent(int(i));
+            if (parent != NO_PARENT) subtreeSpheres[parent] = mergeSpheres(subtreeSpheres[parent], subtreeSpheres[i]);
+        }
+        if (boundsDirty) nodeBvh.build(nodeBoxes);
+        else nodeBvh.refit(nodeBoxes);
+        boundsDirty = false;
+    }
+
+    static glm::vec4 mergeSpheres(const glm::vec4& a, const glm::vec4& b) {
+        if (b.w < 0.0f) return a;
+        if (a.w < 0.0f) return b;
+        glm::vec3 d = glm::vec3(b) - glm::vec3(a);
+        float distance = glm::length(d);
+        if (distance + b.w <= a.w) return a;
+        if (distance + a.w <= b.w) return b;
+        float radius = (distance + a.w + b.w) * 0.5f;
+        return glm::vec4(glm::vec3(a) + d * ((radius - a.w) / distance), radius);
+    }
+
+    // Subarvores fora do frustum sao rejeitadas de uma vez e as que estao
+    // totalmente dentro nao voltam a ser testadas. Devolve se algum no passou
+    // de visivel a invisivel (ou vice-versa).
+    bool cull(const mgl::Frustum& frustum) {
+        size_t n = nodes.getSlotCount();
+        bool changed = visible.size() != n;
+        subtreeState.resize(n);
+        visible.resize(n, 0);
+        for (size_t i = 0; i < n; i++) {
+            int parent = transforms.getParent(int(i));
+            mgl::Frustum::Result state = parent == NO_PARENT ? mgl::Frustum::INTERSECTING
+                                                        : subtreeState[parent];
+            const glm::vec4& subtree = subtreeSpheres[i];
+            const glm::vec4& own = nodeSpheres[i];
+            if (!culling) {
+                state = mgl::Frustum::INSIDE;
+            }
+            else if (subtree.w < 0.0f) {
+                state = mgl::Frustum::OUTSIDE;
             }
+            else if (state == mgl::Frustum::INTERSECTING) {
+                state = frustum.testSphere(glm::vec3(subtree), subtree.w);
+                stats.nodesTested++;
+            }
+            subtreeState[i] = state;
 
-            shader->unbind();
+            // a subarvore intersecta o frustum mas a mesh do proprio no pode estar fora
+            bool isVisible = state != mgl::Frustum::OUTSIDE && own.w >= 0.0f;
+            if (isVisible && state == mgl::Frustum::INTERSECTING && own != subtree) {
+                isVisible = frustum.testSphere(glm::vec3(own), own.w) != mgl::Frustum::OUTSIDE;
+                stats.nodesTested++;
+            }
+            if (own.w >= 0.0f && !isVisible) stats.nodesCulled++;
+            if (visible[i] != isVisible) changed = true;
+            visible[i] = isVisible;
         }
+        return changed;
+    }
 
-        // Draw children
-        for (auto child : children) {
-            child->draw(globalMatrix);
+    // Pipeline so com o vertex stage para o depth pre-pass (ou nullptr)
+    mgl::ProgramPipeline* depthPipelineOf(const mgl::ProgramPipeline* pipeline) const {
+        if (!depthPrepass || !pipeline) return nullptr;
+        auto it = depthPipelines.find(pipeline);
+        return it == depthPipelines.end() ? nullptr : it->second;
+    }
+
+    mgl::ProgramPipeline* depthPipelineOf(const Batch& batch) const {
+        const Renderable& node = *renderables.get(queue[batch.first].index);
+        if (node.transparent) return nullptr;
+        return depthPipelineOf(batch.count > 1 ? node.instancedPipeline : node.pipeline);
+    }
+
+    // Os mesmos draws (indirectos e da fila) so com a profundidade dos nos opacos
+    void drawDepth() {
+        mgl::StateCache& cache = mgl::StateCache::getInstance();
+        cache.colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        const void* boundProgram = nullptr;
+        if (multiDraw) drawIndirect(boundProgram, true);
+        for (const Batch& batch : batches) {
+            mgl::ProgramPipeline* depth = depthPipelineOf(batch);
+            if (!depth) continue;
+            unsigned int index = queue[batch.first].index;
+            Renderable& node = *renderables.get(index);
+            if (boundProgram != depth) {
+                depth->bind();
+                boundProgram = depth;
+                stats.programBinds++;
+            }
+            if (batch.count > 1) {
+                node.mesh->setInstanceBuffer(instanceBuffer);
+                node.mesh->drawInstanced(node.submeshIndex, batch.count, batch.baseInstance);
+            }
+            else {
+                // o vertex stage e o mesmo programa da pipeline completa
+                node.resolve();
+                node.drawMesh(transforms.getWorld(int(index)));
+            }
+            stats.depthDraws++;
         }
+        cache.colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+
+    bool usesIndirect(const Renderable& node) const {
+        return multiDraw && node.instancedPipeline && !node.transparent;
     }
+
+    // O instanceCount dos comandos indirectos e escrito pelo occlusion culler
+    bool selectsOnGpu() const { return multiDraw && occlusion; }
+
+    // Os dados de cada draw (matriz e material) ficam no instance buffer e cada
+    // comando aponta para os seus com baseInstance (equivale a indexar por gl_DrawID)
+    void buildCommands() {
+        indirectNodes.clear();
+        commands.clear();
+        commandNodes.clear();
+        indirectGroups.clear();
+        commandRanges.assign(nodes.getSlotCount(), NodeRange{ 0, 0 });
+
+        for (size_t k = 0; k < renderables.size(); k++) {
+            if (usesIndirect(renderables[k])) indirectNodes.push_back(renderables.getEntity(k));
+        }
+        // agrupar por programa e mesh, mantendo a ordem dos nos dentro do grupo
+        std::stable_sort(indirectNodes.begin(), indirectNodes.end(), [this](unsigned a, unsigned b) {
+            const Renderable& na = *renderables.get(a);
+            const Renderable& nb = *renderables.get(b);
+            if (na.instancedPipeline != nb.instancedPipeline)
+                return std::less<const void*>()(na.instancedPipeline, nb.instancedPipeline);
+            return sortIds[a].mesh < sortIds[b].mesh;
+        });
+
+        size_t i = 0;
+        while (i < indirectNodes.size()) {
+            const Renderable& node = *renderables.get(indirectNodes[i]);
+            if (indirectGroups.empty() || indirectGroups.back().pipeline != node.instancedPipeline
+                || indirectGroups.back().mesh != node.mesh) {
+                IndirectGroup group = { node.instancedPipeline, node.mesh,
+                                        unsigned(commands.size()), 0, 0 };
+                indirectGroups.push_back(group);
+            }
+            // nos seguidos com a mesma submesh partilham um comando instanciado,
+            // a nao ser que o culler escreva a visibilidade de cada no no seu comando
+            size_t end = i + 1;
+            while (!selectsOnGpu() && end < indirectNodes.size()
+                   && renderables.get(indirectNodes[end])->instancedPipeline == node.instancedPipeline
+                   && sortIds[indirectNodes[end]].mesh == sortIds[indirectNodes[i]].mesh) {
+                end++;
+            }
+            IndirectGroup& group = indirectGroups.back();
+            size_t before = commands.size();
+            node.mesh->appendDrawCommands(commands, node.submeshIndex, unsigned(end - i), unsigned(i));
+            group.commandCount += unsigned(commands.size() - before);
+            commandNodes.resize(commands.size(), NodeRange{ unsigned(i), unsigned(end) });
+            commandRanges[indirectNodes[i]] = NodeRange{ unsigned(before), unsigned(commands.size()) };
+            i = end;
+        }
+
+        if (!commands.empty() && !commandBuffer) glGenBuffers(1, &commandBuffer);
+        uploadIndirectInstances();
+        commandsDirty = false;
+    }
+
+    // So os nos visiveis de cada comando vao para o instance buffer;
+    // instanceCount e baseInstance dos comandos sao corrigidos em conformidade.
+    // Se o culler seleciona no GPU vao todos e o instanceCount fica a 0.
+    void uploadIndirectInstances() {
+        if (indirectNodes.empty()) return;
+        instances.clear();
+        for (IndirectGroup& group : indirectGroups) {
+            group.instances = 0;
+            for (unsigned int c = group.firstCommand; c < group.firstCommand + group.commandCount; c++) {
+                mgl::Mesh::DrawCommand& command = commands[c];
+                const NodeRange& range = commandNodes[c];
+                // submeshes da mesma mesh partilham as instancias
+                if (c > group.firstCommand && commandNodes[c - 1].first == range.first) {
+                    command.instanceCount = commands[c - 1].instanceCount;
+                    command.baseInstance = commands[c - 1].baseInstance;
+                    continue;
+                }
+                command.baseInstance = unsigned(instances.size());
+                for (unsigned int k = range.first; k < range.last; k++) {
+                    unsigned int index = indirectNodes[k];
+                    if (!selectsOnGpu() && !drawMask[index]) continue;
+                    const Material& material = *materials.get(index);
+                    mgl::Mesh::InstanceData data;
+                    data.ModelMatrix = transforms.getWorld(int(index));
+                    data.Material = glm::vec4(material.ambientStrength, material.specularStrength,
+                                              material.shininess, 0.0f);
+                    instances.push_back(data);
+                }
+                command.instanceCount = unsigned(instances.size()) - command.baseInstance;
+                group.instances += command.instanceCount;
+                if (selectsOnGpu()) command.instanceCount = 0;
+            }
+        }
+
+        mgl::StateCache& cache = mgl::StateCache::getInstance();
+        cache.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(mgl::Mesh::DrawCommand),
+                     commands.data(), GL_DYNAMIC_DRAW);
+        if (instances.empty()) return;
+        if (!indirectInstanceBuffer) glGenBuffers(1, &indirectInstanceBuffer);
+        cache.bindBuffer(GL_ARRAY_BUFFER, indirectInstanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(mgl::Mesh::InstanceData),
+                     instances.data(), GL_DYNAMIC_DRAW);
+    }
+
+    void drawIndirect(const void*& boundProgram, bool depthOnly) {
+        if (indirectGroups.empty()) return;
+        mgl::StateCache& cache = mgl::StateCache::getInstance();
+        cache.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        for (const IndirectGroup& group : indirectGroups) {
+            if (group.instances == 0) continue;
+            mgl::ProgramPipeline* depth = depthPipelineOf(group.pipeline);
+            mgl::ProgramPipeline* pipeline = depthOnly ? depth : group.pipeline;
+            if (!pipeline) continue;
+            if (boundProgram != pipeline) {
+                pipeline->bind();
+                boundProgram = pipeline;
+                stats.programBinds++;
+            }
+            group.mesh->setInstanceBuffer(indirectInstanceBuffer);
+            if (!depthOnly) cache.depthMask(depth ? GL_FALSE : GL_TRUE);
+            group.mesh->drawIndirect(group.firstCommand * sizeof(mgl::Mesh::DrawCommand),
+                                     group.commandCount);
+            if (depthOnly) {
+                stats.depthDraws++;
+                continue;
+            }
+            stats.draws++;
+            stats.meshBinds++;
+            stats.indirectCommands += group.commandCount;
+            if (selectsOnGpu()) continue; // contados no draw()
+            stats.instances += group.instances;
+            stats.nodesDrawn += group.instances;
+        }
+    }
+
+    // Agrupa os itens seguidos da fila que podem ser instanciados e envia as
+    // matrizes e materiais de todos os grupos num so buffer (baseInstance)
+    void buildBatches() {
+        batches.clear();
+        instances.clear();
+        size_t i = 0;
+        while (i < queue.size()) {
+            const Renderable& node = *renderables.get(queue[i].index);
+            const SortIds& ids = sortIds[queue[i].index];
+            size_t end = i + 1;
+            if (node.instancedPipeline && !node.transparent) {
+                // cada candidato tem de ser opaco (mesmo passe) e usar o mesmo
+                // pipeline instanciado, nao basta partilhar programa e mesh
+                while (end < queue.size()) {
+                    const SortIds& next = sortIds[queue[end].index];
+                    if (next.program != ids.program || next.mesh != ids.mesh) break;
+                    const Renderable& other = *renderables.get(queue[end].index);
+                    if (other.transparent || other.instancedPipeline != node.instancedPipeline) break;
+                    end++;
+                }
+            }
+            Batch batch = { unsigned(i), unsigned(end - i), unsigned(instances.size()) };
+            if (batch.count > 1) {
+                for (size_t k = i; k < end; k++) {
+                    const Material& material = *materials.get(queue[k].index);
+                    mgl::Mesh::InstanceData data;
+                    data.ModelMatrix = transforms.getWorld(int(queue[k].index));
+                    data.Material = glm::vec4(material.ambientStrength, material.specularStrength,
+                                              material.shininess, 0.0f);
+                    instances.push_back(data);
+                }
+            }
+            batches.push_back(batch);
+            i = end;
+        }
+
+        if (!instances.empty()) {
+            mgl::StateCache& cache = mgl::StateCache::getInstance();
+            if (!instanceBuffer) glGenBuffers(1, &instanceBuffer);
+            cache.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+            // realocar (orphaning) evita esperar pelo frame anterior
+            glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(mgl::Mesh::InstanceData),
+                         instances.data(), GL_STREAM_DRAW);
+        }
+    }
+
+    // Ids compactos para caberem nos bits da chave: contados por referencia e
+    // reutilizados depois de libertados, por isso nunca passam do numero de
+    // valores distintos vivos (remover e adicionar nos nao os faz crescer)
+    template <typename T>
+    class IdTable {
+    public:
+        unsigned int acquire(const T& value) {
+            auto it = ids.find(value);
+            if (it == ids.end()) {
+                unsigned int id;
+                if (!freeIds.empty()) {
+                    id = freeIds.back();
+                    freeIds.pop_back();
+                } else {
+                    id = unsigned(entries.size());
+                    entries.emplace_back();
+                    refs.push_back(0);
+                }
+                it = ids.insert(std::make_pair(value, id)).first;
+                entries[id] = it;
+            }
+            refs[it->second]++;
+            return it->second;
+        }
+        void release(unsigned int id) {
+            if (--refs[id] > 0) return;
+            ids.erase(entries[id]);
+            freeIds.push_back(id);
+        }
+        void clear() {
+            ids.clear();
+            entries.clear();
+            refs.clear();
+            freeIds.clear();
+        }
+
+    private:
+        std::map<T, unsigned int> ids;
+        std::vector<typename std::map<T, unsigned int>::iterator> entries; // id -> valor
+        std::vector<unsigned int> refs;
+        std::vector<unsigned int> freeIds;
+    };
+
+    // Ids de ordenacao (programa, mesh, material) de um no com mesh
+    void acquireSortIds(size_t index) {
+        const Renderable& node = *renderables.get(unsigned(index));
+        const void* program = node.pipeline ? (const void*)node.pipeline : (const void*)node.shader;
+        SortIds& ids = sortIds[index];
+        ids.program = programIds.acquire(program);
+        ids.mesh = meshIds.acquire(std::make_pair((const void*)node.mesh, node.submeshIndex));
+        ids.material = materialIds.acquire(*materials.get(unsigned(index)));
+    }
+
+    void releaseSortIds(size_t index) {
+        const SortIds& ids = sortIds[index];
+        programIds.release(ids.program);
+        meshIds.release(ids.mesh);
+        materialIds.release(ids.material);
+    }
+
+    // Slot livre: o no fica sem componentes (ignorado nos passes) e sem pai
+    void destroySlot(size_t index) {
+        int parent = transforms.getParent(int(index));
+        if (parent != NO_PARENT) nodes[parent].children--;
+        nodes.destroy(nodes.getHandle(index));
+        if (renderables.has(unsigned(index))) releaseSortIds(index);
+        renderables.remove(unsigned(index));
+        materials.remove(unsigned(index));
+        transforms.reset(int(index), glm::mat4(1.0f));
+    }
+
+    static const int NO_PARENT = mgl::TransformHierarchy::NO_PARENT;
+
+    mgl::Pool<Entity> nodes;
+    mgl::ComponentStore<Renderable> renderables;
+    mgl::ComponentStore<Material> materials;
+    std::vector<SortIds> sortIds; // por slot, como os vectores seguintes
+    std::vector<unsigned char> removing;
+    mgl::TransformHierarchy transforms;
+    mgl::RenderQueue queue;
+    std::vector<Batch> batches;
+    std::vector<mgl::Mesh::InstanceData> instances;
+    GLuint instanceBuffer = 0;
+    Stats stats;
+
+    bool multiDraw = false;
+    bool commandsDirty = true;
+    std::vector<unsigned int> indirectNodes; // ordem das instancias no buffer
+    std::vector<mgl::Mesh::DrawCommand> commands;
+    std::vector<NodeRange> commandNodes; // um por comando
+    std::vector<NodeRange> commandRanges; // por slot: comandos do no (culler no GPU)
+    std::vector<IndirectGroup> indirectGroups;
+    GLuint indirectInstanceBuffer = 0;
+    GLuint commandBuffer = 0;
+
+    bool culling = true;
+    bool boundsDirty = true;
+    std::vector<glm::vec4> nodeSpheres; // centro e raio em world space
+    std::vector<glm::vec4> subtreeSpheres;
+    std::vector<mgl::Frustum::Result> subtreeState;
+    std::vector<unsigned char> visible; // resultado do frustum culling
+    mgl::Frustum frustum;
+
+    mgl::OcclusionCuller* occlusion = nullptr;
+    bool occlusionReset = true;
+    std::vector<mgl::OcclusionCuller::Box> cullBoxes; // por caixa de nodeBoxes
+    std::vector<unsigned char> occluded; // do ultimo teste Hi-Z lido pelo CPU
+    std::vector<unsigned char> boxVisible; // por caixa de nodeBoxes
+    std::vector<unsigned char> drawMask; // nos desenhados no submit atual
+
+    bool depthPrepass = false;
+    std::map<const mgl::ProgramPipeline*, mgl::ProgramPipeline*> depthPipelines;
+    mgl::Bvh nodeBvh; // primitivas = nos com mesh
+    std::vector<unsigned int> bvhNodes; // primitiva -> no
+    std::vector<mgl::Bvh::Aabb> nodeBoxes;
+
+    IdTable<const void*> programIds;
+    IdTable<std::pair<const void*, int>> meshIds;
+    IdTable<Material> materialIds;
 };
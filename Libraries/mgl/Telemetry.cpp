@@ -0,0 +1,105 @@
+#include "Telemetry.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+const size_t Telemetry::HISTORY;
+
+Telemetry::~Telemetry() {
+    close();
+}
+
+void Telemetry::openCsv(const std::string& filename) {
+    csv.open(filename);
+    if (!csv) throw std::runtime_error("Cannot write " + filename);
+    csv << std::fixed << std::setprecision(4);
+    csvHeader = false;
+}
+
+void Telemetry::openJson(const std::string& filename) {
+    json.open(filename);
+    if (!json) throw std::runtime_error("Cannot write " + filename);
+    json << std::fixed << std::setprecision(4);
+}
+
+void Telemetry::close() {
+    if (csv.is_open()) csv.close();
+    if (json.is_open()) json.close();
+}
+
+void Telemetry::set(const std::string& name, double value) {
+    for (Series& s : series) {
+        if (s.name == name) {
+            s.current = value;
+            return;
+        }
+    }
+    Series s;
+    s.name = name;
+    s.current = value;
+    series.push_back(s);
+}
+
+void Telemetry::endFrame() {
+    for (Series& s : series) {
+        s.last = s.current;
+        if (s.samples.size() < HISTORY) {
+            s.samples.push_back(s.current);
+        } else {
+            s.samples[s.next] = s.current;
+            s.next = (s.next + 1) % HISTORY;
+        }
+    }
+
+    if (csv.is_open()) {
+        if (!csvHeader) {
+            csv << "frame";
+            for (const Series& s : series) csv << "," << s.name;
+            csv << "\n";
+            csvHeader = true;
+            csvColumns = series.size();
+        }
+        csv << frame;
+        for (size_t i = 0; i < csvColumns; i++) csv << "," << series[i].last;
+        csv << "\n";
+    }
+    if (json.is_open()) {
+        // os nomes sao identificadores da app, sem caracteres a escapar
+        json << "{\"frame\":" << frame;
+        for (const Series& s : series) json << ",\"" << s.name << "\":" << s.last;
+        json << "}\n";
+    }
+    frame++;
+}
+
+const Telemetry::Series* Telemetry::find(const std::string& name) const {
+    for (const Series& s : series)
+        if (s.name == name) return &s;
+    return nullptr;
+}
+
+double Telemetry::get(const std::string& name) const {
+    const Series* s = find(name);
+    return s ? s->last : 0.0;
+}
+
+std::vector<double> Telemetry::getHistory(const std::string& name) const {
+    std::vector<double> history;
+    const Series* s = find(name);
+    if (!s) return history;
+    history.insert(history.end(), s->samples.begin() + s->next, s->samples.end());
+    history.insert(history.end(), s->samples.begin(), s->samples.begin() + s->next);
+    return history;
+}
+
+std::vector<int> Telemetry::getHistogram(const std::string& name, int bins, double min, double max) const {
+    if (bins < 1 || max <= min) throw std::runtime_error("Invalid histogram.");
+    std::vector<int> counts(bins, 0);
+    const Series* s = find(name);
+    if (!s) return counts;
+    for (double sample : s->samples) {
+        int bin = int((sample - min) / (max - min) * bins);
+        counts[std::min(std::max(bin, 0), bins - 1)]++;
+    }
+    return counts;
+}
@@ -0,0 +1,52 @@
+// Telemetry.hpp
+#pragma once
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Valores medidos em cada frame (tempo de frame, draw calls, memoria, ...),
+// com as ultimas HISTORY amostras de cada um para o overlay. Em cada
+// endFrame() o frame e acrescentado aos ficheiros abertos: CSV (uma linha
+// por frame, colunas na ordem em que os nomes apareceram no primeiro frame)
+// e JSON Lines (um objeto por frame), para testes longos de estabilidade.
+class Telemetry {
+public:
+    static const size_t HISTORY = 240;
+
+    ~Telemetry();
+
+    void openCsv(const std::string& filename);
+    void openJson(const std::string& filename);
+    void close();
+
+    // Valor do frame atual; nomes novos depois do primeiro frame nao vao para o CSV
+    void set(const std::string& name, double value);
+    void endFrame();
+
+    // Valor do ultimo frame completo (0 se nao existir)
+    double get(const std::string& name) const;
+    // Ultimas amostras, da mais antiga para a mais recente
+    std::vector<double> getHistory(const std::string& name) const;
+    // Contagem das amostras em 'bins' intervalos iguais de [min, max); as que
+    // ficam fora vao para o primeiro ou para o ultimo
+    std::vector<int> getHistogram(const std::string& name, int bins, double min, double max) const;
+    long getFrame() const { return frame; }
+
+private:
+    struct Series {
+        std::string name;
+        double current = 0.0, last = 0.0;
+        std::vector<double> samples;
+        size_t next = 0;
+    };
+
+    std::vector<Series> series; // ordem de chegada
+    std::ofstream csv, json;
+    bool csvHeader = false;
+    size_t csvColumns = 0;
+    long frame = 0;
+
+    const Series* find(const std::string& name) const;
+};
@@ -16,7 +16,14 @@
 #include "OrbitalCamera.hpp"
 #include "SceneGraph.hpp"
 #include "Particle.hpp"
+#include "Benchmark.hpp"
+#include "Telemetry.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 
 ////////////////////////////////////////////////////////////////////////// MYAPP
@@ -25,6 +32,8 @@ class MyApp : public mgl::App {
 public:
   void initCallback(GLFWwindow *win) override;
   void displayCallback(GLFWwindow *win, double elapsed) override;
+  void updateCallback(GLFWwindow *win, double timestep) override;
+  void windowCloseCallback(GLFWwindow *win) override;
   void windowSizeCallback(GLFWwindow *win, int width, int height) override;
   void mouseButtonCallback(GLFWwindow* win, int button, int action, int mods) override;
   void cursorCallback(GLFWwindow* win, double xpos, double ypos) override;
@@ -37,18 +46,49 @@ private:
   mgl::Camera *Camera = nullptr;
   GLint ModelMatrixId;
   mgl::Mesh *Mesh = nullptr;
-  SceneNode* rootNode = nullptr;
+  SceneGraph* scene = nullptr;
+  SceneGraph::Handle sceneRoot;
+  std::vector<SceneGraph::Handle> stoneNodes;
 
   void createMeshes();
   void createShaderPrograms();
   void createCamera();
   void drawScene();
+  mgl::Bvh::Ray screenRay(float x, float y);
+  void pickNode(GLFWwindow* win, double xpos, double ypos);
+  void setStoneCount(int count);
+  void applyBenchmarkCase(const BenchmarkCase& config);
+  void setDynamicResolution(bool enabled);
+  void recordBenchmarkMetrics();
+  void recordTelemetry(double elapsed);
+  void drawOverlay(int width, int height);
 };
 
+// Modo --benchmark (nullptr no modo normal)
+Benchmark* benchmark = nullptr;
+
 OrbitalCamera* cam1;
 OrbitalCamera* cam2;
 OrbitalCamera* activeCam;
 
+// Tempo da simulacao interpolado para o frame atual (a simulacao avanca em passos fixos)
+double renderTime = 0.0;
+
+// Estado produzido por cada passo da simulacao e consumido pelo render. Com
+// --threaded a simulacao corre noutra thread e o triple buffer passa sempre
+// o estado mais recente sem locks.
+struct FrameState {
+    std::vector<Particle> particles;
+    double time = 0.0;       // tempo da simulacao no fim do passo
+    double producedAt = 0.0; // instante (secondsNow) em que foi publicado
+};
+mgl::TripleBuffer<FrameState> frameStates;
+
+double secondsNow() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 //For the callbacks
 double lastX, lastY;
 bool rightPressed = false;
@@ -73,7 +113,44 @@ mgl::Mesh* skyboxMesh = nullptr;
 mgl::ShaderProgram* skyboxShader = nullptr;
 GLuint skyboxCubemap = 0;
 
-//Procedural
+//Procedural (variantes do uber shader procedural-fs.glsl)
+enum ProceduralFeature : unsigned int {
+    FEATURE_ASH      = 1 << 0,
+    FEATURE_STONES   = 1 << 1,
+    FEATURE_TERRAIN  = 1 << 2, // fire falloff
+    FEATURE_EMBERS   = 1 << 3, // emissive pulse
+    FEATURE_TEXTURED = 1 << 4,
+    FEATURE_LIT      = 1 << 5,
+    FEATURE_INSTANCED = 1 << 6 // ModelMatrix e material por instancia
+};
+mgl::ShaderVariants* proceduralShaders = nullptr;
+mgl::ProgramPipeline* ashPipeline = nullptr;
+mgl::ProgramPipeline* stonesPipeline = nullptr;
+mgl::ProgramPipeline* embersPipeline = nullptr;
+mgl::ProgramPipeline* terrainPipeline = nullptr;
+mgl::ProgramPipeline* stonesInstancedPipeline = nullptr;
+mgl::ProgramPipeline* embersInstancedPipeline = nullptr;
+
+// Occlusion culling (tecla O) e fragment shader invocations do grafo de cena
+mgl::OcclusionCuller* occlusionCuller = nullptr;
+mgl::Query* sceneFragments = nullptr;
+
+// Resolucao dinamica (tecla X, --dynres MS): a cena e desenhada numa fracao
+// do ecra que segue o tempo de GPU e depois ampliada
+mgl::DynamicResolution* dynamicResolution = nullptr;
+double dynamicTarget = 16.6;
+// Frame pacing (tecla V, --pacing HZ)
+double pacingInterval = 1.0 / 60.0;
+
+// Telemetria de cada frame: overlay (tecla H) e ficheiros CSV/JSON Lines
+// (--telemetry-csv FILE, --telemetry-json FILE) para testes longos
+Telemetry telemetry;
+mgl::Overlay* overlay = nullptr;
+bool showOverlay = false;
+mgl::Query* scenePrimitives = nullptr;
+std::atomic<double> particleUpdateMs(0.0); // ultimo passo (pode ser noutra thread)
+size_t skyboxBytes = 0;
+
 mgl::Mesh* ashMesh = nullptr;
 mgl::ShaderProgram* ashShader = nullptr;
 
@@ -88,8 +165,12 @@ float fireRadius = 0.5f;
 glm::vec3 fireCenter = glm::vec3(0.0f, -0.3f, 0.0f);
 float fireIntensity = 1.0f;   
 float fireBase = 1.0f;
+// Copias lidas pela simulacao (que pode correr noutra thread)
+std::atomic<float> simFireIntensity(1.0f);
+std::atomic<float> simFireBase(1.0f);
 
 std::vector<Particle> particles;
+std::vector<Particle> renderParticles; // particulas extrapoladas para o frame
 GLuint particleVAO, particleVBO;
 
 //Terrain
@@ -172,19 +253,8 @@ void MyApp::createShaderPrograms() {
         Shaders->addAttribute(mgl::TANGENT_ATTRIBUTE, mgl::Mesh::TANGENT);
     }
 
-    // Uniforms
-    Shaders->addUniform(mgl::MODEL_MATRIX);
-    Shaders->addUniform("baseColor");
-
-    // Lighting uniforms
-    Shaders->addUniform("lightPos");
-    Shaders->addUniform("lightColor");
-    Shaders->addUniform("viewPos");
-
-    // Material uniforms
-    Shaders->addUniform("ambientStrength");
-    Shaders->addUniform("specularStrength");
-    Shaders->addUniform("shininess");
+    // Uniforms (lidos do programa linkado)
+    Shaders->enableIntrospection();
 
     // Camera UBO
     Shaders->addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP);
@@ -202,53 +272,49 @@ void MyApp::createShaderPrograms() {
     skyboxShader->addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
 
     skyboxShader->addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP);
-    skyboxShader->addUniform("skybox");
+    skyboxShader->enableIntrospection();
 
     skyboxShader->create();
 
 
-    // ==================== ASH PROCEDURAL SHADER ====================
-
-    ashShader = new mgl::ShaderProgram();
-    ashShader->addShader(GL_VERTEX_SHADER, "procedural-vs.glsl");
-    ashShader->addShader(GL_FRAGMENT_SHADER, "ash-fs.glsl");
-
-    ashShader->addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
-    ashShader->addAttribute(mgl::NORMAL_ATTRIBUTE, mgl::Mesh::NORMAL);
+    // ==================== PROCEDURAL SHADERS (ASH, STONES, EMBERS, TERRAIN) ====================
 
-    ashShader->addUniform(mgl::MODEL_MATRIX);
-    ashShader->addUniform("lightPos");
-    ashShader->addUniform("lightColor");
-    ashShader->addUniform("viewPos");
+    proceduralShaders = new mgl::ShaderVariants();
+    proceduralShaders->addShader(GL_VERTEX_SHADER, "procedural-vs.glsl");
+    proceduralShaders->addShader(GL_FRAGMENT_SHADER, "procedural-fs.glsl");
 
-    ashShader->addUniform("ambientStrength");
-    ashShader->addUniform("specularStrength");
-    ashShader->addUniform("shininess");
+    proceduralShaders->addFeature(FEATURE_ASH, "ASH");
+    proceduralShaders->addFeature(FEATURE_STONES, "STONES");
+    proceduralShaders->addFeature(FEATURE_TERRAIN, "TERRAIN");
+    proceduralShaders->addFeature(FEATURE_EMBERS, "EMBERS");
+    proceduralShaders->addFeature(FEATURE_TEXTURED, "TEXTURED");
+    proceduralShaders->addFeature(FEATURE_LIT, "LIT");
+    proceduralShaders->addFeature(FEATURE_INSTANCED, "INSTANCED");
 
-    ashShader->addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP);
-    ashShader->create();
+    proceduralShaders->addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
+    proceduralShaders->addAttribute(mgl::NORMAL_ATTRIBUTE, mgl::Mesh::NORMAL);
+    proceduralShaders->addAttribute(mgl::TEXCOORD_ATTRIBUTE, mgl::Mesh::TEXCOORD);
 
+    proceduralShaders->enableIntrospection();
+    proceduralShaders->addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP);
+    proceduralShaders->setCacheDirectory("shadercache");
 
-    // ==================== STONES PROCEDURAL SHADER ====================
+    // variantes criadas na primeira utilizacao (e guardadas em disco);
+    // o procedural-vs.glsl e linkado uma so vez e partilhado pelas 4 pipelines
+    ashPipeline = proceduralShaders->getPipeline(FEATURE_ASH | FEATURE_LIT);
+    stonesPipeline = proceduralShaders->getPipeline(FEATURE_STONES | FEATURE_LIT);
+    embersPipeline = proceduralShaders->getPipeline(FEATURE_EMBERS | FEATURE_LIT);
+    terrainPipeline = proceduralShaders->getPipeline(FEATURE_TERRAIN | FEATURE_LIT);
 
-    stonesShader = new mgl::ShaderProgram();
-    stonesShader->addShader(GL_VERTEX_SHADER, "procedural-vs.glsl");
-    stonesShader->addShader(GL_FRAGMENT_SHADER, "stones-fs.glsl");
+    // pedras e brasas repetem a mesma mesh: um draw instanciado por grupo
+    stonesInstancedPipeline = proceduralShaders->getPipeline(FEATURE_STONES | FEATURE_LIT | FEATURE_INSTANCED);
+    embersInstancedPipeline = proceduralShaders->getPipeline(FEATURE_EMBERS | FEATURE_LIT | FEATURE_INSTANCED);
 
-    stonesShader->addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
-    stonesShader->addAttribute(mgl::NORMAL_ATTRIBUTE, mgl::Mesh::NORMAL);
-
-    stonesShader->addUniform(mgl::MODEL_MATRIX);
-    stonesShader->addUniform("lightPos");
-    stonesShader->addUniform("lightColor");
-    stonesShader->addUniform("viewPos");
-
-    stonesShader->addUniform("ambientStrength");
-    stonesShader->addUniform("specularStrength");
-    stonesShader->addUniform("shininess");
-
-    stonesShader->addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP);
-    stonesShader->create();
+    // programas do fragment stage (uniforms de luz e fogo)
+    ashShader = ashPipeline->getProgram(GL_FRAGMENT_SHADER_BIT);
+    stonesShader = stonesPipeline->getProgram(GL_FRAGMENT_SHADER_BIT);
+    embersShader = embersPipeline->getProgram(GL_FRAGMENT_SHADER_BIT);
+    terrainShader = terrainPipeline->getProgram(GL_FRAGMENT_SHADER_BIT);
 
 
     // ==================== FIRE PARTICLE SHADER ====================
@@ -263,69 +329,13 @@ void MyApp::createShaderPrograms() {
     fireShader->addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
 
     // Uniforms
-    fireShader->addUniform("time");
-    //fireShader->addUniform("fireColor");     
-    //fireShader->addUniform("particleSize");  
+    fireShader->enableIntrospection();
 
     // Camera UBO 
     fireShader->addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP);
 
     fireShader->create();
 
-    // ==================== EMBERS SHADER ====================
-
-    embersShader = new mgl::ShaderProgram();
-    embersShader->addShader(GL_VERTEX_SHADER, "procedural-vs.glsl");
-    embersShader->addShader(GL_FRAGMENT_SHADER, "embers-fs.glsl");
-
-    embersShader->addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
-    embersShader->addAttribute(mgl::NORMAL_ATTRIBUTE, mgl::Mesh::NORMAL);
-
-    embersShader->addUniform(mgl::MODEL_MATRIX);
-    embersShader->addUniform("lightPos");
-    embersShader->addUniform("lightColor");
-    embersShader->addUniform("viewPos");
-
-    //embersShader->addUniform("fireCenter");
-    //embersShader->addUniform("fireRadius");
-    embersShader->addUniform("time");
-
-    embersShader->addUniform("ambientStrength");
-    embersShader->addUniform("specularStrength");
-    embersShader->addUniform("shininess");
-
-    embersShader->addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP);
-    embersShader->create();
-
-    // ==================== TERRAIN SHADER ====================
-
-    terrainShader = new mgl::ShaderProgram();
-    terrainShader->addShader(GL_VERTEX_SHADER, "procedural-vs.glsl");
-    terrainShader->addShader(GL_FRAGMENT_SHADER, "terrain-fs.glsl");
-
-    // atributos
-    terrainShader->addAttribute(mgl::POSITION_ATTRIBUTE, mgl::Mesh::POSITION);
-    terrainShader->addAttribute(mgl::NORMAL_ATTRIBUTE, mgl::Mesh::NORMAL);
-
-    // uniforms base
-    terrainShader->addUniform(mgl::MODEL_MATRIX);
-    terrainShader->addUniform("lightPos");
-    terrainShader->addUniform("lightColor");
-    terrainShader->addUniform("viewPos");
-
-    // material
-    terrainShader->addUniform("ambientStrength");
-    terrainShader->addUniform("specularStrength");
-    terrainShader->addUniform("shininess");
-
-    // fogo
-    terrainShader->addUniform("fireRadius");
-    terrainShader->addUniform("fireColor");
-
-    // camera UBO
-    terrainShader->addUniformBlock(mgl::CAMERA_BLOCK, UBO_BP);
-
-    terrainShader->create();
 
 
 
@@ -371,9 +381,13 @@ glm::mat4 ModelMatrix(1.0f);
 
 
 void MyApp::drawScene() {
+    MGL_PROFILE_SCOPE("drawScene");
+
+    // as mudancas de camara dos callbacks de input sobem ao GPU uma vez por frame
+    Camera->flush();
 
     //FLICKERS
-    float time = (float)glfwGetTime();
+    float time = (float)renderTime;
 
 
     float tSword = time * 6.0f * fireIntensity; // velocidade flicker espada
@@ -416,158 +430,115 @@ void MyApp::drawScene() {
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    Shaders->bind();
-
     //SWORD / GERAL
     
     //lightPos
-    glUniform3fv(
-        Shaders->Uniforms["lightPos"].index,
-        1, glm::value_ptr(lightPos)
-    );
+    Shaders->setUniform("lightPos", lightPos);
 
     glm::vec3 effectiveLightColor = lightEnabled ? flickerLightColor : glm::vec3(0.0f);
 
-    glUniform3fv(
-        Shaders->Uniforms["lightColor"].index,
-        1, glm::value_ptr(effectiveLightColor)
-    );
-
-
-    //lightColor
-    //glUniform3fv(Shaders->Uniforms["lightColor"].index, 1, glm::value_ptr(flickerLightColor));
+    Shaders->setUniform("lightColor", effectiveLightColor);
 
 
     //  Posio da cmara
     glm::vec3 camPos = activeCam->getPosition();
-    glUniform3fv(
-        Shaders->Uniforms["viewPos"].index,
-        1, glm::value_ptr(camPos)
-    );
+    Shaders->setUniform("viewPos", camPos);
     
     
     // ==================== SKYBOX ====================
-    glDepthFunc(GL_LEQUAL);
-    glDisable(GL_CULL_FACE);
-
-    skyboxShader->bind();
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxCubemap);
-    glUniform1i(skyboxShader->Uniforms["skybox"].index, 0);
-
-    skyboxMesh->draw();
-
-    skyboxShader->unbind();
+    mgl::StateCache& cache = mgl::StateCache::getInstance();
+    cache.depthFunc(GL_LEQUAL);
+    cache.setEnabled(GL_CULL_FACE, false);
+    {
+        MGL_PROFILE_SCOPE("Skybox");
+        MGL_PROFILE_GPU("Skybox");
+        skyboxShader->bind();
+        cache.bindTexture(0, GL_TEXTURE_CUBE_MAP, skyboxCubemap);
+        skyboxShader->setUniform("skybox", 0);
+
+        skyboxMesh->draw();
+    }
 
-    glDepthFunc(GL_LESS);
-    glEnable(GL_CULL_FACE);
-  
-    Shaders->unbind();
+    cache.depthFunc(GL_LESS);
+    cache.setEnabled(GL_CULL_FACE, true);
     
 
     // ==================== ASH PROCEDURAL ====================
 
-    ashShader->bind();
-    glUniform3fv(ashShader->Uniforms["lightPos"].index, 1, glm::value_ptr(lightPos));
-
     glm::vec3 effectiveAshLightColor = lightEnabled ? flickerLightColorAsh : glm::vec3(0.0f);
-    glUniform3fv(ashShader->Uniforms["lightColor"].index, 1, glm::value_ptr(effectiveAshLightColor));
-
-    glUniform3fv(ashShader->Uniforms["viewPos"].index, 1, glm::value_ptr(camPos));
-    ashShader->unbind();
+    ashShader->setUniform("lightPos", lightPos);
+    ashShader->setUniform("lightColor", effectiveAshLightColor);
+    ashShader->setUniform("viewPos", camPos);
 
 
     // ==================== STONES PROCEDURAL ====================
 
-    stonesShader->bind();
-    glUniform3fv(stonesShader->Uniforms["lightPos"].index, 1, glm::value_ptr(lightPos));
-
     glm::vec3 effectiveStonesLightColor = lightEnabled ? flickerLightColorStones : glm::vec3(0.0f);
-    glUniform3fv(ashShader->Uniforms["lightColor"].index, 1, glm::value_ptr(effectiveStonesLightColor));
-;
-    glUniform3fv(stonesShader->Uniforms["viewPos"].index, 1, glm::value_ptr(camPos));
-    stonesShader->unbind();
-
-    rootNode->draw(glm::mat4(1.0f));
+    stonesShader->setUniform("lightPos", lightPos);
+    stonesShader->setUniform("lightColor", effectiveStonesLightColor);
+    stonesShader->setUniform("viewPos", camPos);
+    stonesInstancedPipeline->setUniform("lightPos", lightPos);
+    stonesInstancedPipeline->setUniform("lightColor", effectiveStonesLightColor);
+    stonesInstancedPipeline->setUniform("viewPos", camPos);
+
+    {
+        MGL_PROFILE_SCOPE("Scene graph");
+        MGL_PROFILE_GPU("Scene graph");
+        sceneFragments->begin();
+        scenePrimitives->begin();
+        scene->draw(camPos, Camera->getProjectionMatrix() * Camera->getViewMatrix());
+        scenePrimitives->end();
+        sceneFragments->end();
+    }
 
 
     // ==================== FIRE ====================
 
 
-    if (!particles.empty() && particleVAO != 0) {
+    if (!renderParticles.empty() && particleVAO != 0) {
+        MGL_PROFILE_SCOPE("Fire particles");
+        MGL_PROFILE_GPU("Fire particles");
 
-        float time = (float)glfwGetTime();
+        float time = (float)renderTime;
 
         fireShader->bind();
-        glUniform1f(fireShader->Uniforms["time"].index, time);
+        fireShader->setUniform("time", time);
 
         //BLEND ADITIVO
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-        glDepthMask(GL_FALSE);
+        cache.setEnabled(GL_BLEND, true);
+        cache.blendFunc(GL_SRC_ALPHA, GL_ONE);
+        cache.depthMask(GL_FALSE);
 
-        glBindVertexArray(particleVAO);
-        glDrawArrays(GL_POINTS, 0, particles.size());
-        glBindVertexArray(0);
+        cache.bindVertexArray(particleVAO);
+        glDrawArrays(GL_POINTS, 0, renderParticles.size());
 
-        glDepthMask(GL_TRUE);
-        glDisable(GL_BLEND);
-
-        fireShader->unbind();
+        cache.depthMask(GL_TRUE);
+        cache.setEnabled(GL_BLEND, false);
     }
 
     // ==================== EMBERS PROCEDURAL ====================
 
-    embersShader->bind();
-
-    glUniform3fv(embersShader->Uniforms["lightPos"].index, 1, glm::value_ptr(lightPos));
-    glUniform3fv(embersShader->Uniforms["lightColor"].index, 1, glm::value_ptr(flickerLightColorStones));
-    glUniform3fv(embersShader->Uniforms["viewPos"].index, 1, glm::value_ptr(camPos));
-
-    glUniform3fv(embersShader->Uniforms["fireCenter"].index, 1, glm::value_ptr(fireCenter));
-    glUniform1f(embersShader->Uniforms["fireRadius"].index, fireRadius);
-
-    glUniform1f(embersShader->Uniforms["time"].index, (float)glfwGetTime());
-
-    embersShader->unbind();
+    embersShader->setUniform("lightPos", lightPos);
+    embersShader->setUniform("lightColor", flickerLightColorStones);
+    embersShader->setUniform("viewPos", camPos);
+    embersShader->setUniform("time", (float)renderTime);
+    embersInstancedPipeline->setUniform("lightPos", lightPos);
+    embersInstancedPipeline->setUniform("lightColor", flickerLightColorStones);
+    embersInstancedPipeline->setUniform("viewPos", camPos);
+    embersInstancedPipeline->setUniform("time", (float)renderTime);
 
 
     // ==================== TERRAIN ====================
 
-    terrainShader->bind();
-
-    glUniform3fv(
-        terrainShader->Uniforms["lightPos"].index,
-        1, glm::value_ptr(lightPos)
-    );
-
-
     glm::vec3 effectiveTerrainLightColor = lightEnabled ? flickerLightColorTerrain : glm::vec3(0.0f);
 
-    glUniform3fv(
-        terrainShader->Uniforms["lightColor"].index,
-        1, glm::value_ptr(effectiveTerrainLightColor)
-    );
-
-
-
-    glUniform3fv(
-        terrainShader->Uniforms["viewPos"].index,
-        1, glm::value_ptr(camPos)
-    );
+    terrainShader->setUniform("lightPos", lightPos);
+    terrainShader->setUniform("lightColor", effectiveTerrainLightColor);
+    terrainShader->setUniform("viewPos", camPos);
 
     // fogo
-    glUniform1f(
-        terrainShader->Uniforms["fireRadius"].index,
-        3.5f
-    );
-
-    glUniform3fv(
-        terrainShader->Uniforms["fireColor"].index,
-        1, glm::value_ptr(lightColor)
-    );
-
-    terrainShader->unbind();
+    terrainShader->setUniform("fireRadius", 3.5f);
+    terrainShader->setUniform("fireColor", lightColor);
 
 
 
@@ -577,21 +548,18 @@ void MyApp::drawScene() {
 
 ////////////////////////////////////////////////////////////////////// SKYBOX METHODS
 
-GLuint loadCubemapFromCross(const std::string& filename) {
-    int width, height, channels;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
-
-    if (!data) {
-        std::cout << "Failed to load skybox cross image\n";
+// Recorta as 6 faces de uma imagem em cruz (4x3 faces) e cria o cubemap
+GLuint uploadCubemapCross(const unsigned char* data, int width, int height, int channels) {
+    int faceSize = width / 4; //tamanho de cada face
+    if (faceSize <= 0 || faceSize * 3 > height) {
+        std::cout << "Invalid skybox cross image\n";
         return 0;
     }
-
-    int faceSize = width / 4; //tamanho de cada face
     GLenum format = (channels == 4) ? GL_RGBA : GL_RGB; //Define se a textura usa 3 ou 4 canais
 
-    GLuint texID;
+    GLuint texID = 0;
     glGenTextures(1, &texID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texID);
+    mgl::StateCache::getInstance().bindTexture(0, GL_TEXTURE_CUBE_MAP, texID);
 
     // posies das faces na imagem cross
     struct Face { int x, y; };
@@ -631,8 +599,6 @@ GLuint loadCubemapFromCross(const std::string& filename) {
         delete[] faceData;
     }
 
-    stbi_image_free(data);
-
     //Definir parmetros da textura para cubemap (evita bordas)
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -643,6 +609,25 @@ GLuint loadCubemapFromCross(const std::string& filename) {
     return texID;
 }
 
+GLuint loadCubemapFromCross(const std::string& filename) {
+    int width, height, channels;
+    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
+
+    if (!data) {
+        std::cout << "Failed to load skybox cross image\n";
+        return 0;
+    }
+
+    GLuint texID = uploadCubemapCross(data, width, height, channels);
+    stbi_image_free(data);
+    if (texID) {
+        int faceSize = width / 4;
+        skyboxBytes = size_t(6) * faceSize * faceSize * channels;
+        mgl::GpuMemory::getInstance().allocate(mgl::GpuMemory::TEXTURES, skyboxBytes);
+    }
+    return texID;
+}
+
 
 
 // ========================================  FIRE METHODS 
@@ -692,8 +677,9 @@ void initParticles() {
     glGenBuffers(1, &particleVBO);
 
     //Ligar VAO e VBO
-    glBindVertexArray(particleVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
+    mgl::StateCache& cache = mgl::StateCache::getInstance();
+    cache.bindVertexArray(particleVAO);
+    cache.bindBuffer(GL_ARRAY_BUFFER, particleVBO);
 
     //Enviar dados das particulas para o GPU
     glBufferData(
@@ -719,16 +705,18 @@ void initParticles() {
         (void*)(offsetof(Particle, life))
     );
 
-    glBindVertexArray(0);
+    cache.bindVertexArray(0);
 }
 
 
 
 
-void updateParticles(double elapsed) {
+// Um passo fixo da simulacao (Engine::updateCallback)
+void updateParticles(double timestep) {
 
-    float dt = float(elapsed);
-    dt = glm::clamp(dt, 0.0f, 0.033f); // max ~30 FPS
+    float dt = float(timestep);
+    float fireIntensity = simFireIntensity;
+    float fireBase = simFireBase;
 
     for (auto& p : particles) {
 
@@ -754,13 +742,40 @@ void updateParticles(double elapsed) {
 
         p.position += p.velocity * dt;
     }
+}
+
+// Copia o estado da simulacao para o buffer de escrita e publica-o
+void publishFrameState(double time) {
+    FrameState& state = frameStates.getWriteBuffer();
+    state.particles = particles;
+    state.time = time;
+    state.producedAt = secondsNow();
+    frameStates.publish();
+}
+
+// Muda o numero de particulas (benchmark): as novas nascem no proximo passo
+void setParticleCount(int count) {
+    particles.resize(count, Particle{ fireCenter, glm::vec3(0.0f), 1.0f });
+    mgl::StateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, particleVBO);
+    glBufferData(GL_ARRAY_BUFFER, particles.size() * sizeof(Particle), nullptr, GL_DYNAMIC_DRAW);
+    publishFrameState(mgl::Engine::getInstance().getSimulationTime());
+}
+
+// Envia as particulas avancadas 'ahead' segundos desde o ultimo passo
+// (a fracao de passo ainda nao simulada), para o movimento nao saltar
+void uploadParticles(const std::vector<Particle>& source, float ahead) {
+    renderParticles = source;
+    for (auto& p : renderParticles) {
+        p.position += p.velocity * ahead;
+        p.life = glm::min(p.life + ahead * 0.7f, 1.0f);
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
+    mgl::StateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, particleVBO);
     glBufferSubData(
         GL_ARRAY_BUFFER,
         0,
-        particles.size() * sizeof(Particle),
-        particles.data()
+        renderParticles.size() * sizeof(Particle),
+        renderParticles.data()
     );
 }
 
@@ -773,11 +788,37 @@ void MyApp::initCallback(GLFWwindow* win) {
     createShaderPrograms();
     createCamera();
     initParticles(); // funo que cria VAO/VBO
+    publishFrameState(0.0); // estado inicial para o primeiro frame
 
     glm::vec3 bladeColor = glm::vec3(0.4f, 0.1f, 0.1f); 
     glm::vec3 handleColor = glm::vec3(0.6f, 0.1f, 0.2f);  
 
-    rootNode = new SceneNode();
+    scene = new SceneGraph();
+    scene->setMultiDrawIndirect(true);
+
+    // depth pre-pass (tecla D): as mesmas pipelines sem o fragment stage
+    scene->setDepthPipeline(ashPipeline, proceduralShaders->getDepthPipeline(FEATURE_ASH | FEATURE_LIT));
+    scene->setDepthPipeline(stonesPipeline, proceduralShaders->getDepthPipeline(FEATURE_STONES | FEATURE_LIT));
+    scene->setDepthPipeline(embersPipeline, proceduralShaders->getDepthPipeline(FEATURE_EMBERS | FEATURE_LIT));
+    scene->setDepthPipeline(terrainPipeline, proceduralShaders->getDepthPipeline(FEATURE_TERRAIN | FEATURE_LIT));
+    scene->setDepthPipeline(stonesInstancedPipeline,
+        proceduralShaders->getDepthPipeline(FEATURE_STONES | FEATURE_LIT | FEATURE_INSTANCED));
+    scene->setDepthPipeline(embersInstancedPipeline,
+        proceduralShaders->getDepthPipeline(FEATURE_EMBERS | FEATURE_LIT | FEATURE_INSTANCED));
+
+    // em headless pode nao haver janela: o tamanho e o do framebuffer do Engine
+    int winWidth = mgl::Engine::getInstance().WindowWidth;
+    int winHeight = mgl::Engine::getInstance().WindowHeight;
+    if (win) glfwGetWindowSize(win, &winWidth, &winHeight);
+    occlusionCuller = new mgl::OcclusionCuller();
+    occlusionCuller->create("hiz-reduce-cs.glsl", "hiz-cull-cs.glsl");
+    occlusionCuller->resize(winWidth, winHeight);
+    sceneFragments = new mgl::Query(GL_FRAGMENT_SHADER_INVOCATIONS);
+    scenePrimitives = new mgl::Query(GL_PRIMITIVES_SUBMITTED);
+    overlay = new mgl::Overlay();
+    overlay->create("overlay-vs.glsl", "overlay-fs.glsl");
+    SceneGraph::Handle root = scene->addNode(SceneNode(), glm::mat4(1.0f));
+    sceneRoot = root;
     
     // sword
     mgl::Mesh* swordMesh = Mesh;
@@ -785,57 +826,55 @@ void MyApp::initCallback(GLFWwindow* win) {
 
     // Create one SceneNode per submesh
     for (size_t i = 0; i < swordMesh->getMeshCount(); i++) {
-        SceneNode* partNode = new SceneNode();
-        partNode->mesh = swordMesh;
-        partNode->shader = Shaders;
-        partNode->submeshIndex = i;
+        SceneNode partNode;
+        partNode.mesh = swordMesh;
+        partNode.shader = Shaders;
+        partNode.submeshIndex = i;
 
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::scale(model, glm::vec3(0.05f)); // 5% do original
         model = glm::rotate(model,glm::radians(-12.0f), glm::vec3(0.0f, 0.0f, 1.0f));
         //model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
-        partNode->modelMatrix = model;
 
 
         // MATERIAIS DIFERENTES AQUI
         if (i == 0) { // blade
-            partNode->color = bladeColor;
-            partNode->ambientStrength = 0.08f;
-            partNode->specularStrength = 0.8f;
-            partNode->shininess = 4.0f;
+            partNode.color = bladeColor;
+            partNode.ambientStrength = 0.08f;
+            partNode.specularStrength = 0.8f;
+            partNode.shininess = 4.0f;
         }
         else { // handle
-            partNode->color = handleColor;
-            partNode->ambientStrength = 0.15f;
-            partNode->specularStrength = 0.1f;
-            partNode->shininess = 8.0f;
+            partNode.color = handleColor;
+            partNode.ambientStrength = 0.15f;
+            partNode.specularStrength = 0.1f;
+            partNode.shininess = 8.0f;
         }
 
-        rootNode->addChild(partNode);
+        scene->addNode(partNode, model, root);
     }
 
 
     // ==================== DEBUG LIGHT OBJECT ====================
 
     // Criar n da luz
-    SceneNode* lightNode = new SceneNode();
-    lightNode->mesh = lightMesh;
-    lightNode->shader = Shaders;
+    SceneNode lightNode;
+    lightNode.mesh = lightMesh;
+    lightNode.shader = Shaders;
 
     // Transformaes...
     glm::mat4 lightModel = glm::mat4(1.0f);
     lightModel = glm::translate(lightModel, lightPos);
     lightModel = glm::scale(lightModel, glm::vec3(0.05f));
-    lightNode->modelMatrix = lightModel;
 
     // Material emissivo (no depende da luz)
-    lightNode->color = glm::vec3(1.0f, 1.0f, 1.0f);
-    lightNode->ambientStrength = 1.0f;
-    lightNode->specularStrength = 0.0f;
-    lightNode->shininess = 1.0f;
+    lightNode.color = glm::vec3(1.0f, 1.0f, 1.0f);
+    lightNode.ambientStrength = 1.0f;
+    lightNode.specularStrength = 0.0f;
+    lightNode.shininess = 1.0f;
 
     // Adicionar DEBUG CUBE  cena
-    //rootNode->addChild(lightNode);
+    //scene->addNode(lightNode, lightModel, root);
 
 
     // ==================== SKYBOX ====================
@@ -846,56 +885,24 @@ void MyApp::initCallback(GLFWwindow* win) {
 
     // ==================== Ash Procedural ====================
 
-    SceneNode* ashNode = new SceneNode();
-    ashNode->mesh = ashMesh;
-    ashNode->shader = ashShader;
+    SceneNode ashNode;
+    ashNode.mesh = ashMesh;
+    ashNode.pipeline = ashPipeline;
 
     //Transformaes...
     glm::mat4 ashModel = glm::mat4(1.0f);
     ashModel = glm::scale(ashModel, glm::vec3(1.0f));
-    ashNode->modelMatrix = ashModel;
 
-    ashNode->ambientStrength = 0.9f;
-    ashNode->specularStrength = 0.5f;
-    ashNode->shininess = 1.0f;
+    ashNode.ambientStrength = 0.9f;
+    ashNode.specularStrength = 0.5f;
+    ashNode.shininess = 1.0f;
 
-    rootNode->addChild(ashNode);
+    scene->addNode(ashNode, ashModel, root);
 
 
     // ==================== Stone Procedural ====================
 
-    int stoneCount = 12;
-    float radius = 1.2f;
-
-    for (int i = 0; i < stoneCount; i++) {
-
-        SceneNode* stoneNode = new SceneNode();
-        stoneNode->mesh = stoneMesh;
-        stoneNode->shader = stonesShader;
-
-        float angle = (2.0f * 3.1415f * i) / stoneCount;
-
-        float x = cos(angle) * radius;
-        float z = sin(angle) * radius;
-
-        // Pequena variao aleatria (de scale e rotation)
-        float scale = 0.18f + 0.05f * (rand() / float(RAND_MAX));
-        float rotation = rand() / float(RAND_MAX) * 360.0f;
-
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(x, -0.4f, z));
-        model = glm::rotate(model, glm::radians(rotation), glm::vec3(0, 1, 0));
-        model = glm::scale(model, glm::vec3(scale));
-
-        stoneNode->modelMatrix = model;
-
-        // Material
-        stoneNode->ambientStrength = 0.12f;
-        stoneNode->specularStrength = 0.25f;
-        stoneNode->shininess = 16.0f;
-
-        rootNode->addChild(stoneNode);
-    }
+    setStoneCount(12);
 
     std::vector<glm::vec3> emberPositions = {
     glm::vec3(0.58f, 0.2f, -0.3f),
@@ -907,55 +914,370 @@ void MyApp::initCallback(GLFWwindow* win) {
 
     for (const glm::vec3& offset : emberPositions) {
 
-        SceneNode* emberStone = new SceneNode();
-        emberStone->mesh = stoneMesh;          // mesma mesh
-        emberStone->shader = embersShader;     // shader das brasas
+        SceneNode emberStone;
+        emberStone.mesh = stoneMesh;          // mesma mesh
+        emberStone.pipeline = embersPipeline; // shader das brasas
+        emberStone.instancedPipeline = embersInstancedPipeline;
 
         glm::vec3 pos = fireCenter + offset;
 
         glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
         model = glm::scale(model, glm::vec3(0.06f)); // pequenas
-        emberStone->modelMatrix = model;
 
-        emberStone->ambientStrength = 0.18f;
-        emberStone->specularStrength = 0.03f;
-        emberStone->shininess = 1.0f;
+        emberStone.ambientStrength = 0.18f;
+        emberStone.specularStrength = 0.03f;
+        emberStone.shininess = 1.0f;
 
-        rootNode->addChild(emberStone);
+        scene->addNode(emberStone, model, root);
     }
 
     // ==================== TERRAIN ====================
 
-    SceneNode* terrainNode = new SceneNode();
-    terrainNode->mesh = terrainMesh;
+    SceneNode terrainNode;
+    terrainNode.mesh = terrainMesh;
 
-    terrainNode->shader = terrainShader;
+    terrainNode.pipeline = terrainPipeline;
 
     glm::mat4 terrainModel = glm::mat4(1.0f);
     terrainModel = glm::translate(terrainModel, glm::vec3(0.0f, -1.2f, -3.0f));
     terrainModel = glm::scale(terrainModel, glm::vec3(20.0f)); 
-    terrainNode->modelMatrix = terrainModel;
 
-    terrainNode->ambientStrength = 0.35f;
-    terrainNode->specularStrength = 0.05f;
-    terrainNode->shininess = 8.0f;
+    terrainNode.ambientStrength = 0.35f;
+    terrainNode.specularStrength = 0.05f;
+    terrainNode.shininess = 8.0f;
 
-    rootNode->addChild(terrainNode);
+    scene->addNode(terrainNode, terrainModel, root);
 
 }
 
 
+// As primeiras 12 pedras fazem o circulo da fogueira; as restantes (benchmark)
+// ficam numa espiral a volta dele
+void MyApp::setStoneCount(int count) {
+    for (SceneGraph::Handle stone : stoneNodes) scene->removeNode(stone);
+    stoneNodes.clear();
+
+    int stoneCount = 12;
+    float radius = 1.2f;
+
+    for (int i = 0; i < count; i++) {
+
+        SceneNode stoneNode;
+        stoneNode.mesh = stoneMesh;
+        stoneNode.pipeline = stonesPipeline;
+        stoneNode.instancedPipeline = stonesInstancedPipeline;
+
+        float x, z;
+        if (i < stoneCount) {
+            float angle = (2.0f * 3.1415f * i) / stoneCount;
+            x = cos(angle) * radius;
+            z = sin(angle) * radius;
+        }
+        else {
+            float j = float(i - stoneCount);
+            float angle = j * 2.39996f; // angulo de ouro
+            float r = radius + 0.4f + 0.2f * sqrt(j);
+            x = cos(angle) * r;
+            z = sin(angle) * r;
+        }
+
+        // Pequena variao aleatria (de scale e rotation)
+        float scale = 0.18f + 0.05f * (rand() / float(RAND_MAX));
+        float rotation = rand() / float(RAND_MAX) * 360.0f;
+
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(x, -0.4f, z));
+        model = glm::rotate(model, glm::radians(rotation), glm::vec3(0, 1, 0));
+        model = glm::scale(model, glm::vec3(scale));
+
+        // Material
+        stoneNode.ambientStrength = 0.12f;
+        stoneNode.specularStrength = 0.25f;
+        stoneNode.shininess = 16.0f;
+
+        stoneNodes.push_back(scene->addNode(stoneNode, model, sceneRoot));
+    }
+}
+
 
 void MyApp::windowSizeCallback(GLFWwindow *win, int winx, int winy) {
     glViewport(0, 0, winx, winy);
+    occlusionCuller->resize(winx, winy);
     float aspect = float(winx) / float(winy);
     Camera->setProjectionMatrix(activeCam->getProjectionMatrix(aspect));
 }
 
+// Liberta os recursos GL enquanto o contexto ainda existe. O grafo so guarda
+// ponteiros: e apagado primeiro, depois o que os nos referem.
+void MyApp::windowCloseCallback(GLFWwindow *win) {
+    delete scene;
+    scene = nullptr;
+    delete dynamicResolution;
+    dynamicResolution = nullptr;
+    delete occlusionCuller;
+    occlusionCuller = nullptr;
+    delete sceneFragments;
+    sceneFragments = nullptr;
+    delete scenePrimitives;
+    scenePrimitives = nullptr;
+    delete overlay;
+    overlay = nullptr;
+
+    // os pipelines e os programas das variantes pertencem ao ShaderVariants
+    delete proceduralShaders;
+    proceduralShaders = nullptr;
+    ashShader = stonesShader = embersShader = terrainShader = nullptr;
+    delete Shaders;
+    Shaders = nullptr;
+    delete skyboxShader;
+    skyboxShader = nullptr;
+    delete fireShader;
+    fireShader = nullptr;
+    // os shader objects partilhados pelos programas ficam na cache ate aqui
+    mgl::ShaderProgram::clearShaderCache();
+
+    delete Mesh;
+    Mesh = nullptr;
+    delete lightMesh;
+    lightMesh = nullptr;
+    delete skyboxMesh;
+    skyboxMesh = nullptr;
+    delete ashMesh;
+    ashMesh = nullptr;
+    delete stoneMesh;
+    stoneMesh = nullptr;
+    delete terrainMesh;
+    terrainMesh = nullptr;
+
+    delete Camera;
+    Camera = nullptr;
+    delete cam1;
+    delete cam2;
+    cam1 = cam2 = activeCam = nullptr;
+
+    glDeleteTextures(1, &skyboxCubemap);
+    skyboxCubemap = 0;
+    mgl::GpuMemory::getInstance().release(mgl::GpuMemory::TEXTURES, skyboxBytes);
+    skyboxBytes = 0;
+    glDeleteVertexArrays(1, &particleVAO);
+    glDeleteBuffers(1, &particleVBO);
+    particleVAO = particleVBO = 0;
+}
+
+void MyApp::updateCallback(GLFWwindow *, double timestep) {
+    {
+        MGL_PROFILE_SCOPE("updateParticles");
+        double start = secondsNow();
+        updateParticles(timestep);
+        particleUpdateMs = (secondsNow() - start) * 1000.0;
+    }
+    publishFrameState(mgl::Engine::getInstance().getSimulationTime() + timestep);
+}
+
+// O estado a desenhar e o ultimo publicado. Sem thread, avanca-se a fracao de
+// passo acumulada; com thread, a idade do estado (limitada a um passo).
+// "Snapshot age" no profiler mede a latencia acrescentada pelo pipeline.
 void MyApp::displayCallback(GLFWwindow *win, double elapsed) { 
     //std::cout << elapsed;
-    updateParticles(elapsed); //Atualizao por frame
+    mgl::Engine& engine = mgl::Engine::getInstance();
+    if (benchmark) {
+        if (benchmark->beginFrame()) applyBenchmarkCase(benchmark->getCase());
+        benchmark->moveCamera(*activeCam);
+        Camera->setViewMatrix(activeCam->getViewMatrix());
+    }
+    frameStates.fetch();
+    const FrameState& state = frameStates.getReadBuffer();
+    double age = secondsNow() - state.producedAt;
+    mgl::Profiler::getInstance().addSample("Snapshot age", age * 1000.0);
+    double ahead = engine.isThreadedUpdate()
+        ? glm::min(age, engine.getFixedTimestep())
+        : engine.getInterpolationAlpha() * engine.getFixedTimestep();
+    renderTime = state.time + ahead;
+    uploadParticles(state.particles, float(ahead));
+
+    // O Hi-Z do occlusion culling segue o tamanho do render
+    if (dynamicResolution) {
+        dynamicResolution->begin(engine.WindowWidth, engine.WindowHeight);
+        occlusionCuller->resize(dynamicResolution->getRenderWidth(),
+                                dynamicResolution->getRenderHeight());
+    }
     drawScene(); 
+    if (dynamicResolution) {
+        mgl::Framebuffer* target = engine.getFramebuffer();
+        dynamicResolution->end(target ? target->getId() : 0);
+    }
+
+    recordTelemetry(elapsed);
+    if (showOverlay) {
+        int width = engine.WindowWidth, height = engine.WindowHeight;
+        if (win) glfwGetWindowSize(win, &width, &height);
+        drawOverlay(width, height);
+    }
+
+    // no benchmark o tempo de frame inclui o trabalho do GPU
+    if (benchmark) {
+        glFinish();
+        if (benchmark->isLastFrame()) recordBenchmarkMetrics();
+    }
+}
+
+// Parametros de um caso do benchmark: resolucao do framebuffer headless,
+// tamanho da cena e opcoes do render
+void MyApp::applyBenchmarkCase(const BenchmarkCase& config) {
+    std::cout << "Benchmark case " << config.name << std::endl;
+    mgl::Engine& engine = mgl::Engine::getInstance();
+    engine.WindowWidth = config.width;
+    engine.WindowHeight = config.height;
+    engine.getFramebuffer()->create(config.width, config.height);
+    engine.getFramebuffer()->bind();
+    activeCam = cam1;
+    windowSizeCallback(nullptr, config.width, config.height);
+
+    setParticleCount(config.particles);
+    setStoneCount(config.stones);
+    scene->setMultiDrawIndirect(config.multiDraw);
+    scene->setDepthPrepass(config.depthPrepass);
+    scene->setOcclusionCuller(config.occlusion ? occlusionCuller : nullptr);
+    setDynamicResolution(false);
+    if (config.dynamicResolution > 0.0) {
+        dynamicTarget = config.dynamicResolution;
+        setDynamicResolution(true);
+    }
+}
+
+// Raios por segundo contra as BVHs de triangulos de uma mesh sozinha (model
+// space): grelha de raios paralelos ao eixo mais curto da caixa, a atravessa-la
+// toda. O primeiro raio constroi as BVHs e fica fora da medicao.
+double meshRaysPerSecond(mgl::Mesh& mesh, int grid, int& hits) {
+    const mgl::Mesh::Bounds& bounds = mesh.getBounds();
+    glm::vec3 size = bounds.Max - bounds.Min;
+    int axis = size.x < size.y ? (size.x < size.z ? 0 : 2) : (size.y < size.z ? 1 : 2);
+    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+    float margin = 0.01f * glm::max(size.x, glm::max(size.y, size.z)) + 1e-3f;
+    mgl::Bvh::Ray ray{ bounds.Center, glm::vec3(0.0f) };
+    ray.Origin[axis] = bounds.Max[axis] + margin;
+    ray.Direction[axis] = -(size[axis] + 2.0f * margin);
+    float distance = 1.0f;
+    mesh.intersect(ray, distance);
+
+    // amostras fora do centro das celulas: numa mesh em grelha regular (como o
+    // terreno) os raios caiam exatamente nas arestas e falhavam os dois triangulos
+    hits = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int y = 0; y < grid; y++) {
+        for (int x = 0; x < grid; x++) {
+            ray.Origin[u] = bounds.Min[u] + size[u] * (x + 0.618034f) / grid;
+            ray.Origin[v] = bounds.Min[v] + size[v] * (y + 0.381966f) / grid;
+            distance = 1.0f;
+            if (mesh.intersect(ray, distance)) hits++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return grid * grid / glm::max(seconds, 1e-9);
+}
+
+// Metricas do ultimo frame medido e raios por segundo contra a BVH da cena
+// (uma grelha de raios pelo ecra, como o picking do rato) e contra as BVHs de
+// triangulos da espada e do terreno
+void MyApp::recordBenchmarkMetrics() {
+    const SceneGraph::Stats& stats = scene->getStats();
+    benchmark->setMetric("draws", stats.draws);
+    benchmark->setMetric("nodes_drawn", stats.nodesDrawn);
+    benchmark->setMetric("nodes_culled", stats.nodesCulled);
+    benchmark->setMetric("nodes_occluded", stats.nodesOccluded);
+    benchmark->setMetric("fragment_invocations", double(sceneFragments->getResult()));
+    if (dynamicResolution) benchmark->setMetric("render_scale", dynamicResolution->getScale());
+
+    const int grid = 64;
+    int hits = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int y = 0; y < grid; y++) {
+        for (int x = 0; x < grid; x++) {
+            float distance = 1.0f;
+            mgl::Bvh::Ray ray = screenRay((x + 0.5f) * 2.0f / grid - 1.0f, (y + 0.5f) * 2.0f / grid - 1.0f);
+            if (scene->isValid(scene->pick(ray, distance))) hits++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    benchmark->setMetric("rays_per_second", grid * grid / glm::max(seconds, 1e-9));
+    benchmark->setMetric("ray_hits", hits);
+
+    benchmark->setMetric("rays_per_second_sword", meshRaysPerSecond(*Mesh, grid, hits));
+    benchmark->setMetric("ray_hits_sword", hits);
+    benchmark->setMetric("rays_per_second_terrain", meshRaysPerSecond(*terrainMesh, grid, hits));
+    benchmark->setMetric("ray_hits_terrain", hits);
+}
+
+////////////////////////////////////////////////////////////////////// TELEMETRY
+
+// Valores do frame para o overlay e para os ficheiros de telemetria. Os
+// contadores do GLRecorder (instalado pela tecla H ou pelas opcoes
+// --telemetry-*) e as queries chegam com um ou mais frames de atraso.
+void MyApp::recordTelemetry(double elapsed) {
+    const mgl::GLRecorder::Counts& gl = mgl::GLRecorder::getInstance().getFrameCounts();
+    const mgl::GpuMemory& memory = mgl::GpuMemory::getInstance();
+    int alive = 0;
+    for (const Particle& p : renderParticles)
+        if (p.life < 1.0f) alive++;
+    // o glDrawArrays das particulas e o do overlay sao GL 1.1: o GLRecorder nao os ve
+    int untracked = (renderParticles.empty() ? 0 : 1) + (showOverlay ? 1 : 0);
+
+    telemetry.set("frame_ms", elapsed * 1000.0);
+    telemetry.set("draw_calls", double(gl.DrawCalls + untracked));
+    telemetry.set("triangles", double(scenePrimitives->getResult()));
+    telemetry.set("alive_particles", alive);
+    telemetry.set("particle_update_ms", particleUpdateMs);
+    telemetry.set("uniform_uploads", double(gl.UniformUploads));
+    telemetry.set("mesh_buffer_mb", memory.getBytes(mgl::GpuMemory::MESH_BUFFERS) / (1024.0 * 1024.0));
+    telemetry.set("texture_mb", memory.getBytes(mgl::GpuMemory::TEXTURES) / (1024.0 * 1024.0));
+    telemetry.set("render_scale", dynamicResolution ? dynamicResolution->getScale() : 1.0);
+    telemetry.endFrame();
+}
+
+// Painel no canto superior esquerdo: valores do ultimo frame e histograma do
+// tempo de frame (barras de 2 ms, verde ate 60 Hz, amarelo ate 30 Hz)
+void MyApp::drawOverlay(int width, int height) {
+    const float scale = 2.0f;
+    const float line = mgl::Overlay::LINE_HEIGHT * scale;
+    const int bins = 20;
+    const double binMs = 2.0;
+    const float barWidth = 12.0f, barHeight = 60.0f;
+    const glm::vec4 white(1.0f), green(0.3f, 0.9f, 0.3f, 1.0f),
+        yellow(1.0f, 0.8f, 0.2f, 1.0f), red(1.0f, 0.3f, 0.2f, 1.0f);
+
+    char lines[8][64];
+    int n = 0;
+    double frameMs = telemetry.get("frame_ms");
+    snprintf(lines[n++], 64, "FRAME %.2f MS  %.0f FPS", frameMs, frameMs > 0.0 ? 1000.0 / frameMs : 0.0);
+    snprintf(lines[n++], 64, "DRAW CALLS %.0f", telemetry.get("draw_calls"));
+    snprintf(lines[n++], 64, "TRIANGLES %.0f", telemetry.get("triangles"));
+    snprintf(lines[n++], 64, "PARTICLES %.0f  UPDATE %.3f MS", telemetry.get("alive_particles"),
+             telemetry.get("particle_update_ms"));
+    snprintf(lines[n++], 64, "UNIFORM UPLOADS %.0f", telemetry.get("uniform_uploads"));
+    snprintf(lines[n++], 64, "GPU MESH %.1f MB  TEX %.1f MB", telemetry.get("mesh_buffer_mb"),
+             telemetry.get("texture_mb"));
+    if (dynamicResolution) snprintf(lines[n++], 64, "RENDER SCALE %.2f", telemetry.get("render_scale"));
+
+    std::vector<int> histogram = telemetry.getHistogram("frame_ms", bins, 0.0, bins * binMs);
+    int highest = 1;
+    for (int count : histogram) highest = glm::max(highest, count);
+
+    const float x = 10.0f, y = 10.0f, pad = 8.0f;
+    overlay->begin(width, height);
+    overlay->quad(x, y, 400.0f, pad * 3.0f + n * line + barHeight + line, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+    for (int i = 0; i < n; i++) overlay->text(x + pad, y + pad + i * line, lines[i], white, scale);
+
+    float base = y + pad * 2.0f + n * line + barHeight;
+    for (int i = 0; i < bins; i++) {
+        float h = barHeight * histogram[i] / float(highest);
+        double ms = (i + 1) * binMs;
+        const glm::vec4& color = ms <= 1000.0 / 60.0 + binMs ? green : ms <= 1000.0 / 30.0 + binMs ? yellow : red;
+        overlay->quad(x + pad + i * barWidth, base - h, barWidth - 2.0f, h, color);
+    }
+    overlay->text(x + pad, base + 4.0f, "0", white, scale);
+    overlay->text(x + pad + bins * barWidth - 2.0f * mgl::Overlay::ADVANCE * scale, base + 4.0f, "40", white, scale);
+    overlay->text(x + pad + bins * barWidth + pad, base + 4.0f, "MS", white, scale);
+    overlay->end();
 }
 
 
@@ -973,6 +1295,7 @@ void MyApp::mouseButtonCallback(GLFWwindow* win, int button, int action, int mod
         if (action == GLFW_PRESS) {
             leftPressed = true;
             glfwGetCursorPos(win, &lastX, &lastY);
+            pickNode(win, lastX, lastY);
         }
         else if (action == GLFW_RELEASE) {
             leftPressed = false;
@@ -981,6 +1304,32 @@ void MyApp::mouseButtonCallback(GLFWwindow* win, int button, int action, int mod
 
 }
 
+// Raio do near plane ao far plane por um ponto do ecra em NDC (t em [0,1])
+mgl::Bvh::Ray MyApp::screenRay(float x, float y) {
+    glm::mat4 inverse = glm::inverse(Camera->getProjectionMatrix() * Camera->getViewMatrix());
+    glm::vec4 nearPoint = inverse * glm::vec4(x, y, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverse * glm::vec4(x, y, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+    return mgl::Bvh::Ray{ origin, direction };
+}
+
+void MyApp::pickNode(GLFWwindow* win, double xpos, double ypos) {
+    int width, height;
+    glfwGetWindowSize(win, &width, &height);
+    if (width == 0 || height == 0) return;
+    float x = float(2.0 * xpos / width - 1.0);
+    float y = float(1.0 - 2.0 * ypos / height);
+
+    float distance = 1.0f;
+    mgl::Bvh::Ray ray = screenRay(x, y);
+    SceneGraph::Handle node = scene->pick(ray, distance);
+    if (scene->isValid(node)) {
+        std::cout << "Picked node " << node.Index << " at distance "
+                  << distance * glm::length(ray.Direction) << std::endl;
+    }
+}
+
 void MyApp::cursorCallback(GLFWwindow* win, double xpos, double ypos) {
     float dx = float(xpos - lastX);
     float dy = float(ypos - lastY);
@@ -1001,6 +1350,21 @@ void MyApp::scrollCallback(GLFWwindow* win, double xoffset, double yoffset) {
 }
 
 
+// Intervalo entre frames apresentados (e escala do render, se dinamica)
+void reportPresentInterval() {
+    mgl::Engine& engine = mgl::Engine::getInstance();
+    mgl::Profiler::Stats stats = mgl::Profiler::getInstance().getStats("Present interval");
+    if (stats.Count == 0) return;
+    std::cout << "Present interval with pacing " << (engine.getFramePacing() > 0.0 ? "on" : "off")
+              << ": mean " << stats.Mean << " ms, stddev " << stats.StdDev << " ms, p99 "
+              << stats.P99 << " ms (" << stats.Count << " frames)" << std::endl;
+    if (dynamicResolution) {
+        std::cout << "Render scale " << dynamicResolution->getScale() << ", GPU frame "
+                  << dynamicResolution->getGpuTime() << " ms (target " << dynamicTarget
+                  << " ms)" << std::endl;
+    }
+}
+
 void MyApp::keyCallback(GLFWwindow* win, int key, int scancode, int action, int mods) {
     int width, height;
     glfwGetWindowSize(win, &width, &height);
@@ -1043,22 +1407,594 @@ void MyApp::keyCallback(GLFWwindow* win, int key, int scancode, int action, int
     }
 
     fireBase = glm::clamp(fireBase, 0.5f, 1.5f);
+    simFireIntensity = fireIntensity;
+    simFireBase = fireBase;
 
     if (key == GLFW_KEY_L && action == GLFW_PRESS) {
         lightEnabled = !lightEnabled;
     }
+
+    // Alternar entre multi-draw indirect e a render queue (para comparar)
+    if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+        scene->setMultiDrawIndirect(!scene->isMultiDrawIndirect());
+        std::cout << "Multi-draw indirect: " << (scene->isMultiDrawIndirect() ? "on" : "off")
+                  << std::endl;
+    }
+
+    // Chamadas GL do ultimo frame (enviadas / filtradas pelo StateCache)
+    // e binds poupados pela ordenacao da render queue
+    if (key == GLFW_KEY_I && action == GLFW_PRESS) {
+        mgl::StateCache& cache = mgl::StateCache::getInstance();
+        std::cout << "GL state calls: " << cache.getIssuedCalls() << " issued, "
+                  << cache.getFilteredCalls() << " filtered" << std::endl;
+
+        const SceneGraph::Stats& stats = scene->getStats();
+        std::cout << "Render queue: " << stats.draws << " draws ("
+                  << stats.instances << " instances, "
+                  << stats.indirectCommands << " indirect commands), "
+                  << stats.draws - stats.programBinds << " program binds saved, "
+                  << stats.draws - stats.meshBinds << " mesh binds saved, "
+                  << stats.draws - stats.materialUploads << " material uploads saved"
+                  << std::endl;
+        std::cout << "Frustum culling: " << stats.nodesTested << " nodes tested, "
+                  << stats.nodesCulled << " culled, " << stats.nodesDrawn << " drawn"
+                  << std::endl;
+        std::cout << "Occlusion culling: " << stats.nodesOccluded << " occluded, "
+                  << sceneFragments->getResult() << " scene fragment shader invocations"
+                  << std::endl;
+        std::cout << "Depth pre-pass: " << stats.depthDraws << " draws" << std::endl;
+    }
+
+    // Liga/desliga o depth pre-pass (comparar as fragment shader invocations)
+    if (key == GLFW_KEY_D && action == GLFW_PRESS) {
+        scene->setDepthPrepass(!scene->isDepthPrepass());
+        std::cout << "Depth pre-pass: " << (scene->isDepthPrepass() ? "on" : "off") << std::endl;
+    }
+
+    // Liga/desliga o occlusion culling (comparar as fragment shader invocations)
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+        scene->setOcclusionCuller(scene->isOcclusionCulling() ? nullptr : occlusionCuller);
+        std::cout << "Occlusion culling: " << (scene->isOcclusionCulling() ? "on" : "off")
+                  << std::endl;
+    }
+
+    // Tempos do profiler (media e percentis dos ultimos frames)
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        mgl::Profiler::getInstance().printStats(std::cout);
+    }
+
+    // Inicia/termina a captura de um trace (abrir trace.json em chrome://tracing)
+    if (key == GLFW_KEY_R && action == GLFW_PRESS) {
+        mgl::Profiler& profiler = mgl::Profiler::getInstance();
+        if (!profiler.isCapturing()) {
+            profiler.startCapture();
+            std::cout << "Profiler capture started" << std::endl;
+        }
+        else {
+            profiler.stopCapture();
+            profiler.writeChromeTrace("trace.json");
+            std::cout << "Profiler capture written to trace.json" << std::endl;
+        }
+    }
+
+    // Liga/desliga o frustum culling (para comparar os draws)
+    if (key == GLFW_KEY_F && action == GLFW_PRESS) {
+        scene->setCulling(!scene->isCulling());
+        std::cout << "Frustum culling: " << (scene->isCulling() ? "on" : "off") << std::endl;
+    }
+
+    // Mostra/esconde o overlay de telemetria (instala o GLRecorder para os contadores)
+    if (key == GLFW_KEY_H && action == GLFW_PRESS) {
+        showOverlay = !showOverlay;
+        mgl::GLRecorder& recorder = mgl::GLRecorder::getInstance();
+        if (showOverlay && !recorder.isInstalled()) recorder.install();
+    }
+
+    // Liga/desliga a resolucao dinamica
+    if (key == GLFW_KEY_X && action == GLFW_PRESS) {
+        setDynamicResolution(!dynamicResolution);
+        std::cout << "Dynamic resolution: " << (dynamicResolution ? "on" : "off") << std::endl;
+    }
+
+    // Liga/desliga o frame pacing; mostra a variancia do intervalo entre
+    // frames no modo que termina e comeca a medir o outro
+    if (key == GLFW_KEY_V && action == GLFW_PRESS) {
+        mgl::Engine& engine = mgl::Engine::getInstance();
+        reportPresentInterval();
+        mgl::Profiler::getInstance().clear();
+        engine.setFramePacing(engine.getFramePacing() > 0.0 ? 0.0 : pacingInterval);
+        std::cout << "Frame pacing: " << (engine.getFramePacing() > 0.0 ? "on" : "off") << std::endl;
+    }
+}
+
+void MyApp::setDynamicResolution(bool enabled) {
+    if (enabled == (dynamicResolution != nullptr)) return;
+    mgl::Engine& engine = mgl::Engine::getInstance();
+    if (enabled) {
+        dynamicResolution = new mgl::DynamicResolution();
+        dynamicResolution->setTarget(dynamicTarget);
+    }
+    else {
+        delete dynamicResolution;
+        dynamicResolution = nullptr;
+        // o Hi-Z volta ao tamanho da janela
+        windowSizeCallback(nullptr, engine.WindowWidth, engine.WindowHeight);
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////// BENCHMARK
+
+// Casos do --benchmark: a cena normal, percursos de orbita e zoom, mais
+// particulas e pedras, multi-draw indirect contra a render queue e o depth
+// pre-pass em 1080p e 4K, com e sem resolucao dinamica
+std::vector<BenchmarkCase> bonfireBenchmark() {
+  std::vector<BenchmarkCase> cases;
+  BenchmarkCase base;
+  base.keys = orbitPath(10.0f, -20.0f);
+
+  BenchmarkCase c = base;
+  c.name = "orbit";
+  cases.push_back(c);
+
+  c = base;
+  c.name = "zoom";
+  c.path = "zoom";
+  c.keys = zoomPath(15.0f, 3.0f, -20.0f);
+  cases.push_back(c);
+
+  c = base;
+  c.name = "particles-50k";
+  c.particles = 50000;
+  cases.push_back(c);
+
+  c = base;
+  c.name = "stones-10k";
+  c.stones = 10000;
+  c.keys = orbitPath(30.0f, -40.0f);
+  cases.push_back(c);
+
+  c.name = "stones-10k-queue";
+  c.multiDraw = false;
+  cases.push_back(c);
+
+  const int sizes[][2] = { { 1920, 1080 }, { 3840, 2160 } };
+  const char *labels[] = { "1080p", "4k" };
+  for (int i = 0; i < 2; i++) {
+    c = base;
+    c.width = sizes[i][0];
+    c.height = sizes[i][1];
+    c.name = labels[i];
+    cases.push_back(c);
+    c.name = std::string(labels[i]) + "-prepass";
+    c.depthPrepass = true;
+    cases.push_back(c);
+  }
+  // 4K com resolucao dinamica a 60 Hz: comparar o p95 e o stddev com "4k"
+  c.name = "4k-dynres";
+  c.depthPrepass = false;
+  c.dynamicResolution = 16.6;
+  cases.push_back(c);
+  return cases;
+}
+
+/////////////////////////////////////////////////////////////// MICROBENCHMARKS
+
+// Grelha n x n no plano XZ (normais e texcoords), como vinda do Assimp
+aiScene* gridScene(int n) {
+    aiScene* scene = new aiScene();
+    scene->mRootNode = new aiNode();
+    scene->mNumMeshes = 1;
+    scene->mMeshes = new aiMesh*[1];
+    aiMesh* mesh = scene->mMeshes[0] = new aiMesh();
+    mesh->mName = "grid";
+    mesh->mNumVertices = unsigned((n + 1) * (n + 1));
+    mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+    mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+    mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+    mesh->mNumUVComponents[0] = 2;
+    for (int z = 0; z <= n; z++) {
+        for (int x = 0; x <= n; x++) {
+            unsigned v = unsigned(z * (n + 1) + x);
+            mesh->mVertices[v] = aiVector3D(float(x) / n - 0.5f, 0.0f, float(z) / n - 0.5f);
+            mesh->mNormals[v] = aiVector3D(0.0f, 1.0f, 0.0f);
+            mesh->mTextureCoords[0][v] = aiVector3D(float(x) / n, float(z) / n, 0.0f);
+        }
+    }
+    mesh->mNumFaces = unsigned(2 * n * n);
+    mesh->mFaces = new aiFace[mesh->mNumFaces];
+    unsigned f = 0;
+    for (int z = 0; z < n; z++) {
+        for (int x = 0; x < n; x++) {
+            unsigned v = unsigned(z * (n + 1) + x);
+            unsigned quad[2][3] = { { v, v + n + 1, v + 1 }, { v + 1, v + n + 1, v + n + 2 } };
+            for (auto& triangle : quad) {
+                aiFace& face = mesh->mFaces[f++];
+                face.mNumIndices = 3;
+                face.mIndices = new unsigned int[3];
+                std::copy(triangle, triangle + 3, face.mIndices);
+            }
+        }
+    }
+    return scene;
 }
 
+// Uniforms do blinnPhong preenchidos a mao (sem introspecao: nao ha contexto)
+void addStubUniforms(mgl::ShaderProgram& program) {
+    const std::pair<const char*, GLenum> uniforms[] = {
+        { mgl::MODEL_MATRIX, GL_FLOAT_MAT4 }, { "baseColor", GL_FLOAT_VEC3 },
+        { "lightPos", GL_FLOAT_VEC3 }, { "lightColor", GL_FLOAT_VEC3 },
+        { "viewPos", GL_FLOAT_VEC3 }, { "ambientStrength", GL_FLOAT },
+        { "specularStrength", GL_FLOAT }, { "shininess", GL_FLOAT }
+    };
+    for (const auto& uniform : uniforms) {
+        GLint location = GLint(program.UniformTable.size());
+        program.UniformTable.push_back({ uniform.first, location, uniform.second, 1, -1, -1 });
+    }
+}
+
+// No com todos os dados juntos (descricao, slots de uniforms e filhos), como
+// no grafo antes dos componentes: referencia para NodeLayout/*
+struct NodeRecord {
+    SceneNode node;
+    mgl::ShaderProgram* slotsVertex = nullptr;
+    mgl::ShaderProgram* slotsFragment = nullptr;
+    GLint slots[5] = { -1, -1, -1, -1, -1 };
+    unsigned int children = 0;
+};
+
+struct NodeSortIds {
+    unsigned int program, mesh, material;
+};
+
+// --microbench: funcoes do frame medidas isoladamente sobre o NullGL (sem GPU
+// nem janela), para comparar o custo de CPU entre versoes
+int runMicrobenchmarks(const char* jsonPath) {
+    mgl::NullGL::install();
+    Microbench bench;
+
+    const int particleCounts[] = { 1000, 5000, 50000 };
+    for (int count : particleCounts) {
+        bench.add("updateParticles/" + std::to_string(count), [count](int iterations) {
+            particles.assign(count, Particle{ fireCenter, glm::vec3(0.0f), 1.0f });
+            for (int i = 0; i < iterations; i++) updateParticles(1.0 / 60.0);
+            doNotOptimize(particles[0]);
+        });
+    }
+
+    bench.add("randomInCircle", [](int iterations) {
+        for (int i = 0; i < iterations; i++) doNotOptimize(randomInCircle(fireRadius));
+    });
+
+    OrbitalCamera camera(glm::vec3(0.0f), 10.0f);
+    camera.rotate(30.0f, -20.0f);
+    bench.add("OrbitalCamera::getViewMatrix", [&camera](int iterations) {
+        for (int i = 0; i < iterations; i++) doNotOptimize(camera.getViewMatrix());
+    });
+
+    mgl::ShaderProgram shader;
+    addStubUniforms(shader);
+    bench.add("ShaderProgram::getUniformSlot", [&shader](int iterations) {
+        for (int i = 0; i < iterations; i++) doNotOptimize(shader.getUniformSlot("shininess"));
+    });
+    bench.add("ShaderProgram::setUniform/name", [&shader](int iterations) {
+        for (int i = 0; i < iterations; i++) shader.setUniform("shininess", 32.0f);
+    });
+    bench.add("ShaderProgram::setUniform/slot", [&shader](int iterations) {
+        GLint slot = shader.getUniformSlot("shininess");
+        for (int i = 0; i < iterations; i++) shader.setUniform(slot, 32.0f);
+    });
+
+    const int gridSizes[] = { 16, 256 };
+    for (int n : gridSizes) {
+        std::shared_ptr<aiScene> grid(gridScene(n));
+        bench.add("Mesh::create/" + std::to_string(2 * n * n), [grid](int iterations) {
+            for (int i = 0; i < iterations; i++) {
+                mgl::Mesh mesh;
+                mesh.create(grid.get());
+            }
+        });
+    }
+
+    // Pedras em grelha: o frustum apanha cerca de metade
+    std::unique_ptr<aiScene> cube(gridScene(4));
+    mgl::Mesh nodeMesh;
+    nodeMesh.create(cube.get());
+    const glm::mat4 viewProjection = camera.getProjectionMatrix(4.0f / 3.0f) * camera.getViewMatrix();
+    const int nodeCounts[] = { 100, 1000, 10000, 100000 };
+    for (int count : nodeCounts) {
+        std::shared_ptr<SceneGraph> graph = std::make_shared<SceneGraph>();
+        graph->setMultiDrawIndirect(false);
+        SceneNode node;
+        node.mesh = &nodeMesh;
+        node.shader = &shader;
+        int side = int(std::ceil(std::sqrt(float(count))));
+        for (int i = 0; i < count; i++) {
+            node.color = glm::vec3(float(i % 7) / 7.0f, 0.5f, 0.5f);
+            glm::vec3 position(float(i % side) - side * 0.5f, 0.0f, float(i / side) - side * 0.5f);
+            graph->addNode(node, glm::translate(glm::mat4(1.0f), position * 0.5f));
+        }
+        glm::vec3 viewPos = camera.getPosition();
+        std::string name = "SceneGraph::draw/" + std::to_string(count);
+        bench.add(name, [graph, viewPos, viewProjection](int iterations) {
+            for (int i = 0; i < iterations; i++) graph->draw(viewPos, viewProjection);
+        });
+
+        // Chamadas GL de um frame estavel (o primeiro tambem constroi a cena)
+        mgl::GLRecorder& recorder = mgl::GLRecorder::getInstance();
+        recorder.install();
+        for (int frame = 0; frame < 2; frame++) {
+            graph->draw(viewPos, viewProjection);
+            recorder.endFrame();
+        }
+        recorder.uninstall();
+        const mgl::GLRecorder::Counts& calls = recorder.getFrameCounts();
+        bench.setCounter(name, "gl_calls", double(calls.Calls));
+        bench.setCounter(name, "draw_calls", double(calls.DrawCalls));
+        bench.setCounter(name, "state_changes", double(calls.StateChanges));
+        bench.setCounter(name, "redundant_binds", double(calls.RedundantBinds));
+        bench.setCounter(name, "uniform_uploads", double(calls.UniformUploads));
+        std::cout << name << ":\n";
+        recorder.printFrame(std::cout);
+    }
+
+    // Spawn/destroy: 250 grupos (pai e 3 filhos) criados e removidos por iteracao
+    // numa cena com 1000 nos fixos. Depois do aquecimento o pool reutiliza os
+    // slots livres: se o numero de slots ou de realocacoes mudar, falha.
+    std::shared_ptr<SceneGraph> churnGraph = std::make_shared<SceneGraph>();
+    {
+        SceneNode node;
+        node.mesh = &nodeMesh;
+        node.shader = &shader;
+        for (int i = 0; i < 1000; i++) {
+            churnGraph->addNode(node, glm::translate(glm::mat4(1.0f), glm::vec3(float(i % 32), 0.0f, float(i / 32))));
+        }
+    }
+    auto churn = [churnGraph, &nodeMesh, &shader](int iterations) {
+        SceneNode node;
+        node.mesh = &nodeMesh;
+        node.shader = &shader;
+        std::vector<SceneGraph::Handle> groups;
+        groups.reserve(250);
+        for (int n = 0; n < iterations; n++) {
+            groups.clear();
+            for (int g = 0; g < 250; g++) {
+                glm::mat4 position = glm::translate(glm::mat4(1.0f), glm::vec3(float(g), 1.0f, 0.0f));
+                SceneGraph::Handle parent = churnGraph->addNode(node, position);
+                for (int c = 0; c < 3; c++) {
+                    churnGraph->addNode(node, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, float(c), 0.0f)), parent);
+                }
+                groups.push_back(parent);
+            }
+            for (SceneGraph::Handle parent : groups) churnGraph->removeNode(parent);
+        }
+        doNotOptimize(churnGraph->size());
+    };
+    churn(1);
+    const size_t churnSlots = churnGraph->getSlotCount();
+    const size_t churnGrowths = churnGraph->getGrowthCount();
+    bench.add("SceneGraph::addNode+removeNode/1000", churn);
+
+    // Emissao dos itens da RenderQueue com 100k nos, um em cada quatro sem mesh
+    // (nos de grupo): percorrer os nos inteiros contra o array denso de
+    // Renderable (o material fica noutro array e os nos de grupo nao aparecem)
+    {
+        const int count = 100000;
+        std::shared_ptr<std::vector<NodeRecord>> records = std::make_shared<std::vector<NodeRecord>>(count);
+        std::shared_ptr<mgl::ComponentStore<Renderable>> renderables = std::make_shared<mgl::ComponentStore<Renderable>>();
+        std::shared_ptr<mgl::TransformHierarchy> world = std::make_shared<mgl::TransformHierarchy>();
+        std::shared_ptr<std::vector<NodeSortIds>> ids = std::make_shared<std::vector<NodeSortIds>>(count);
+        int side = int(std::ceil(std::sqrt(float(count))));
+        for (int i = 0; i < count; i++) {
+            glm::vec3 position(float(i % side) - side * 0.5f, 0.0f, float(i / side) - side * 0.5f);
+            world->add(glm::translate(glm::mat4(1.0f), position * 0.5f));
+            (*ids)[i] = { 0u, 0u, unsigned(i % 7) };
+            if (i % 4 == 3) continue;
+            NodeRecord& record = (*records)[i];
+            record.node.mesh = &nodeMesh;
+            record.node.shader = &shader;
+            record.node.color = glm::vec3(float(i % 7) / 7.0f, 0.5f, 0.5f);
+            Renderable& renderable = renderables->add(unsigned(i));
+            renderable.mesh = &nodeMesh;
+            renderable.shader = &shader;
+        }
+        world->update();
+        glm::vec3 viewPos = camera.getPosition();
+        std::shared_ptr<mgl::RenderQueue> queue = std::make_shared<mgl::RenderQueue>();
+        auto push = [world, ids, queue, viewPos](unsigned int i, bool transparent) {
+            float distance = glm::length(glm::vec3(world->getWorld(int(i))[3]) - viewPos);
+            float depth = distance / (distance + 1.0f);
+            mgl::RenderQueue::Pass pass = transparent ? mgl::RenderQueue::PASS_TRANSPARENT
+                                                      : mgl::RenderQueue::PASS_OPAQUE;
+            const NodeSortIds& id = (*ids)[i];
+            queue->push(mgl::RenderQueue::makeKey(pass, id.program, id.mesh, id.material, depth), i);
+        };
+        bench.add("NodeLayout/SceneNode/100000", [records, queue, push](int iterations) {
+            for (int n = 0; n < iterations; n++) {
+                queue->clear();
+                for (size_t i = 0; i < records->size(); i++) {
+                    const SceneNode& node = (*records)[i].node;
+                    if (!node.mesh || !(node.shader || node.pipeline)) continue;
+                    push(unsigned(i), node.transparent);
+                }
+                doNotOptimize(queue->size());
+            }
+        });
+        bench.add("NodeLayout/ComponentStore/100000", [renderables, queue, push](int iterations) {
+            for (int n = 0; n < iterations; n++) {
+                queue->clear();
+                for (size_t k = 0; k < renderables->size(); k++) {
+                    const Renderable& node = (*renderables)[k];
+                    if (!node.mesh || !(node.shader || node.pipeline)) continue;
+                    push(renderables->getEntity(k), node.transparent);
+                }
+                doNotOptimize(queue->size());
+            }
+        });
+        bench.setCounter("NodeLayout/SceneNode/100000", "bytes_per_node", double(sizeof(NodeRecord)));
+        bench.setCounter("NodeLayout/ComponentStore/100000", "bytes_per_node", double(sizeof(Renderable)));
+    }
+
+    // Arvore quaternaria (pai de i e (i - 1) / 4): o no raiz muda em cada
+    // iteracao e todos os descendentes sao recalculados
+    const int transformCounts[] = { 10000, 100000, 1000000 };
+    for (int count : transformCounts) {
+        std::shared_ptr<mgl::TransformHierarchy> hierarchy = std::make_shared<mgl::TransformHierarchy>();
+        for (int i = 0; i < count; i++) {
+            int parent = i == 0 ? mgl::TransformHierarchy::NO_PARENT : (i - 1) / 4;
+            glm::mat4 local = glm::translate(glm::mat4(1.0f), glm::vec3(float(i % 4) - 1.5f, 1.0f, 0.0f));
+            hierarchy->add(glm::rotate(local, glm::radians(15.0f), glm::vec3(0.0f, 1.0f, 0.0f)), parent);
+        }
+        int depth = 0;
+        for (int node = count - 1; node != mgl::TransformHierarchy::NO_PARENT; node = hierarchy->getParent(node)) depth++;
+        hierarchy->update();
+        std::string name = "TransformHierarchy::update/" + std::to_string(count);
+        bench.add(name, [hierarchy](int iterations) {
+            for (int i = 0; i < iterations; i++) {
+                hierarchy->setLocal(0, glm::rotate(glm::mat4(1.0f), float(i) * 0.01f, glm::vec3(0.0f, 1.0f, 0.0f)));
+                doNotOptimize(hierarchy->update());
+            }
+        });
+        bench.setCounter(name, "nodes", double(count));
+        bench.setCounter(name, "depth", double(depth));
+    }
+
+    // Cruz de 2048x1536 (faces de 512)
+    std::vector<unsigned char> cross(2048 * 1536 * 3);
+    for (size_t i = 0; i < cross.size(); i++) cross[i] = (unsigned char)(i * 31);
+    bench.add("uploadCubemapCross/512", [&cross](int iterations) {
+        for (int i = 0; i < iterations; i++) doNotOptimize(uploadCubemapCross(cross.data(), 2048, 1536, 3));
+    });
+
+    bench.run(std::cout);
+    bench.setCounter("SceneGraph::addNode+removeNode/1000", "slot_count", double(churnGraph->getSlotCount()));
+    bench.setCounter("SceneGraph::addNode+removeNode/1000", "pool_growths",
+                     double(churnGraph->getGrowthCount() - churnGrowths));
+    if (jsonPath) {
+        bench.writeJson(jsonPath);
+        std::cout << "Microbenchmarks written to " << jsonPath << std::endl;
+    }
+    if (churnGraph->getSlotCount() != churnSlots || churnGraph->getGrowthCount() != churnGrowths) {
+        std::cerr << "SceneGraph::addNode+removeNode: the node pool grew after warm-up ("
+                  << churnSlots << " -> " << churnGraph->getSlotCount() << " slots, "
+                  << churnGraph->getGrowthCount() - churnGrowths << " reallocations)" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
 
 /////////////////////////////////////////////////////////////////////////// MAIN
 
+// --headless FRAMES [--size WxH] [--dump PREFIX]: render offscreen a 60 Hz
+// --trace FILE: grava um Chrome trace de todos os frames
+// --threaded: simulacao numa thread propria, em paralelo com o render
+// --benchmark FILE [--bench-frames N] [--baseline FILE] [--threshold F]:
+//   corre os casos de bonfireBenchmark() em headless e grava os resultados em
+//   JSON; com um baseline, sai com erro se o p95 do frame de algum caso piorar
+//   mais que F (por omissao 0.1 = 10%)
+// --microbench [FILE]: corre os microbenchmarks sem GPU (JSON opcional)
+// --gl-stats: conta as chamadas GL de cada frame e mostra as do ultimo
+// --gl-trace FILE: grava todas as chamadas GL (mgl::GLRecorder)
+// --dynres MS: resolucao dinamica com um alvo de MS ms de GPU por frame
+// --pacing HZ: apresenta os frames a HZ por segundo (tecla V liga/desliga)
+// --telemetry-csv FILE, --telemetry-json FILE: grava a telemetria de cada
+//   frame em CSV ou JSON Lines (tecla H mostra-a no ecra)
 int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--microbench")) {
+      bool hasFile = i + 1 < argc && argv[i + 1][0] != '-';
+      return runMicrobenchmarks(hasFile ? argv[i + 1] : nullptr);
+    }
+  }
   mgl::Engine &engine = mgl::Engine::getInstance();
   engine.setApp(new MyApp());
   engine.setOpenGL(4, 6);
-  engine.setWindow(800, 600, "CGJ Final Project - Ricardo Vieira", 0, 1);
+  int width = 800, height = 600;
+  const char *tracePath = nullptr;
+  bool threaded = false;
+  const char *benchmarkPath = nullptr;
+  const char *baselinePath = nullptr;
+  int benchmarkFrames = 120;
+  double threshold = 0.1;
+  bool glStats = false;
+  bool dynres = false;
+  const char *glTracePath = nullptr;
+  bool telemetryFiles = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--headless") && i + 1 < argc) {
+      engine.setHeadless(atoi(argv[++i]), 1.0 / 60.0);
+    } else if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+      sscanf(argv[++i], "%dx%d", &width, &height);
+    } else if (!strcmp(argv[i], "--dump") && i + 1 < argc) {
+      engine.setFrameDump(argv[++i]);
+    } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else if (!strcmp(argv[i], "--threaded")) {
+      threaded = true;
+    } else if (!strcmp(argv[i], "--benchmark") && i + 1 < argc) {
+      benchmarkPath = argv[++i];
+    } else if (!strcmp(argv[i], "--bench-frames") && i + 1 < argc) {
+      benchmarkFrames = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) {
+      baselinePath = argv[++i];
+    } else if (!strcmp(argv[i], "--threshold") && i + 1 < argc) {
+      threshold = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--gl-stats")) {
+      glStats = true;
+    } else if (!strcmp(argv[i], "--gl-trace") && i + 1 < argc) {
+      glTracePath = argv[++i];
+    } else if (!strcmp(argv[i], "--dynres") && i + 1 < argc) {
+      dynres = true;
+      dynamicTarget = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--pacing") && i + 1 < argc) {
+      pacingInterval = 1.0 / atof(argv[++i]);
+      engine.setFramePacing(pacingInterval);
+    } else if (!strcmp(argv[i], "--telemetry-csv") && i + 1 < argc) {
+      telemetry.openCsv(argv[++i]);
+      telemetryFiles = true;
+    } else if (!strcmp(argv[i], "--telemetry-json") && i + 1 < argc) {
+      telemetry.openJson(argv[++i]);
+      telemetryFiles = true;
+    }
+  }
+  if (benchmarkPath) {
+    std::vector<BenchmarkCase> cases = bonfireBenchmark();
+    benchmark = new Benchmark(cases, benchmarkFrames, 10);
+    engine.setHeadless(benchmark->getTotalFrames(), 1.0 / 60.0);
+    width = cases[0].width;
+    height = cases[0].height;
+  }
+  mgl::Profiler &profiler = mgl::Profiler::getInstance();
+  if (tracePath) profiler.startCapture();
+  engine.setWindow(width, height, "CGJ Final Project - Ricardo Vieira", 0, 1);
   engine.init();
+  mgl::GLRecorder &recorder = mgl::GLRecorder::getInstance();
+  if (glStats || glTracePath || telemetryFiles) recorder.install();
+  if (glTracePath) recorder.startCapture();
+  engine.setThreadedUpdate(threaded);
+  if (dynres && !benchmark) {
+    dynamicResolution = new mgl::DynamicResolution();
+    dynamicResolution->setTarget(dynamicTarget);
+  }
   engine.run();
+  if (tracePath) profiler.writeChromeTrace(tracePath);
+  if (glTracePath) recorder.writeCommands(glTracePath);
+  if (glStats) recorder.printFrame(std::cout);
+  telemetry.close();
+  if (benchmark) {
+    benchmark->finish();
+    benchmark->writeJson(benchmarkPath);
+    std::cout << "Benchmark written to " << benchmarkPath << std::endl;
+    if (baselinePath && benchmark->compare(baselinePath, threshold, std::cout) > 0) {
+      std::cout << "Frame time regressed beyond " << threshold * 100.0 << "%" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  } else if (engine.isHeadless()) {
+    profiler.printStats(std::cout);
+  } else {
+    reportPresentInterval();
+  }
   exit(EXIT_SUCCESS);
 }
 
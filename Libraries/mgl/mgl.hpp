@@ -12,12 +12,31 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#include "./mglApp.hpp"          // IWYU pragma: keep
-#include "./mglCamera.hpp"       // IWYU pragma: keep
-#include "./mglConventions.hpp"  // IWYU pragma: keep
-#include "./mglError.hpp"        // IWYU pragma: keep
-#include "./mglMesh.hpp"         // IWYU pragma: keep
-#include "./mglScenegraph.hpp"   // IWYU pragma: keep
-#include "./mglShader.hpp"       // IWYU pragma: keep
+#include "./mglApp.hpp"                 // IWYU pragma: keep
+#include "./mglBvh.hpp"                 // IWYU pragma: keep
+#include "./mglCamera.hpp"              // IWYU pragma: keep
+#include "./mglComponentStore.hpp"      // IWYU pragma: keep
+#include "./mglConventions.hpp"         // IWYU pragma: keep
+#include "./mglDynamicResolution.hpp"   // IWYU pragma: keep
+#include "./mglError.hpp"               // IWYU pragma: keep
+#include "./mglFramebuffer.hpp"         // IWYU pragma: keep
+#include "./mglFrustum.hpp"             // IWYU pragma: keep
+#include "./mglGLRecorder.hpp"          // IWYU pragma: keep
+#include "./mglGpuMemory.hpp"           // IWYU pragma: keep
+#include "./mglMesh.hpp"                // IWYU pragma: keep
+#include "./mglNullGL.hpp"              // IWYU pragma: keep
+#include "./mglOcclusionCuller.hpp"     // IWYU pragma: keep
+#include "./mglOverlay.hpp"             // IWYU pragma: keep
+#include "./mglPool.hpp"                // IWYU pragma: keep
+#include "./mglProfiler.hpp"            // IWYU pragma: keep
+#include "./mglProgramPipeline.hpp"     // IWYU pragma: keep
+#include "./mglQuery.hpp"               // IWYU pragma: keep
+#include "./mglRenderQueue.hpp"         // IWYU pragma: keep
+#include "./mglScenegraph.hpp"          // IWYU pragma: keep
+#include "./mglShader.hpp"              // IWYU pragma: keep
+#include "./mglShaderVariants.hpp"      // IWYU pragma: keep
+#include "./mglStateCache.hpp"          // IWYU pragma: keep
+#include "./mglTransformHierarchy.hpp"  // IWYU pragma: keep
+#include "./mglTripleBuffer.hpp"        // IWYU pragma: keep
 
 #endif /* MGL_HPP */
@@ -9,16 +9,32 @@
 #include "./mglApp.hpp"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
 #include "./mglError.hpp" // IWYU pragma: keep -- required in debug mode
+#include "./mglFramebuffer.hpp"
+#include "./mglGLRecorder.hpp"
+#include "./mglProfiler.hpp"
+#include "./mglStateCache.hpp"
 
 namespace mgl {
 
 /////////////////////////////////////////////////////////////// STATIC CALLBACKS
 
 static void window_close_callback(GLFWwindow *window) {
+  Engine::getInstance().stopUpdateThread();
   Engine::getInstance().getApp()->windowCloseCallback(window);
 }
 
@@ -60,7 +76,12 @@ static void joystick_callback(int jid, int event) {
 Engine::Engine(void)
     : WindowWidth(640), WindowHeight(480), GlApp(nullptr), Window(nullptr),
       WindowTitle("OpenGL App GLFW Window 2025(c) Carlos Martinho"), GlMajor(3),
-      GlMinor(3), Fullscreen(0), Vsync(0) {}
+      GlMinor(3), Fullscreen(0), Vsync(0), FixedStep(1.0 / 60.0),
+      Accumulator(0.0), SimulationTime(0.0), MaxSteps(8), Threaded(false),
+      UpdateRunning(false), PacingInterval(0.0), Presented(false),
+      Headless(false), HeadlessFrames(0),
+      Timestep(1.0 / 60.0), Target(nullptr), EglDisplay(nullptr),
+      EglContext(nullptr), EglSurface(nullptr) {}
 
 Engine::~Engine(void) {}
 
@@ -87,6 +108,47 @@ void Engine::setWindow(int width, int height, const char *title, int fullscreen,
   Vsync = vsync;
 }
 
+void Engine::setFixedTimestep(double timestep, int max_steps) {
+  if (timestep <= 0.0 || max_steps < 1)
+    throw std::runtime_error("Invalid fixed timestep.");
+  FixedStep = timestep;
+  MaxSteps = max_steps;
+}
+
+double Engine::getFixedTimestep() const { return FixedStep; }
+
+double Engine::getInterpolationAlpha() const {
+  return Threaded ? 0.0 : Accumulator / FixedStep;
+}
+
+double Engine::getSimulationTime() const { return SimulationTime; }
+
+void Engine::setThreadedUpdate(bool threaded) {
+  if (UpdateThread.joinable())
+    throw std::runtime_error("Update thread already running.");
+  Threaded = threaded && !Headless;
+}
+
+bool Engine::isThreadedUpdate() const { return Threaded; }
+
+void Engine::setFramePacing(double interval) {
+  PacingInterval = interval > 0.0 ? interval : 0.0;
+}
+
+double Engine::getFramePacing() const { return PacingInterval; }
+
+void Engine::setHeadless(int frames, double timestep) {
+  Headless = true;
+  HeadlessFrames = frames;
+  Timestep = timestep;
+}
+
+void Engine::setFrameDump(const std::string &prefix) { DumpPrefix = prefix; }
+
+bool Engine::isHeadless() const { return Headless; }
+
+Framebuffer *Engine::getFramebuffer() { return Target; }
+
 /////////////////////////////////////////////////////////////////////////// INIT
 
 void Engine::setupWindow() {
@@ -124,6 +186,105 @@ void Engine::setupGLFW() {
   setupCallbacks();
 }
 
+// Without a display the context is created directly with EGL: the Mesa
+// surfaceless platform if available (llvmpipe on GPU-less servers), else the
+// default display. Rendering goes to an FBO, so the context needs a surface
+// only when EGL_KHR_surfaceless_context is missing (then a 1x1 pbuffer).
+void Engine::setupEGL() {
+#ifdef __linux__
+  EGLDisplay display = EGL_NO_DISPLAY;
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+          eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (getPlatformDisplay)
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                 EGL_DEFAULT_DISPLAY, nullptr);
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+      throw std::runtime_error("Failed to initialize EGL.");
+  }
+  EglDisplay = display;
+  if (!eglBindAPI(EGL_OPENGL_API))
+    throw std::runtime_error("EGL does not support desktop OpenGL.");
+
+  const EGLint config_attributes[] = {EGL_SURFACE_TYPE,
+                                      EGL_PBUFFER_BIT,
+                                      EGL_RENDERABLE_TYPE,
+                                      EGL_OPENGL_BIT,
+                                      EGL_RED_SIZE,
+                                      8,
+                                      EGL_GREEN_SIZE,
+                                      8,
+                                      EGL_BLUE_SIZE,
+                                      8,
+                                      EGL_NONE};
+  EGLConfig config = nullptr;
+  EGLint count = 0;
+  if (!eglChooseConfig(display, config_attributes, &config, 1, &count) ||
+      count == 0)
+    throw std::runtime_error("No EGL config for desktop OpenGL.");
+
+  EGLint context_attributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                 GlMajor,
+                                 EGL_CONTEXT_MINOR_VERSION,
+                                 GlMinor,
+                                 EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                 EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifdef DEBUG
+                                 EGL_CONTEXT_OPENGL_DEBUG,
+                                 EGL_TRUE,
+#endif
+                                 EGL_NONE};
+  EGLContext context =
+      eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+  if (context == EGL_NO_CONTEXT) {
+    // 3.2 core gets the highest core version the driver has
+    std::cerr << "EGL: OpenGL " << GlMajor << "." << GlMinor
+              << " core unavailable, using the highest supported version."
+              << std::endl;
+    context_attributes[1] = 3;
+    context_attributes[3] = 2;
+    context =
+        eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    if (context == EGL_NO_CONTEXT)
+      throw std::runtime_error("Failed to create EGL context.");
+  }
+  EglContext = context;
+
+  EGLSurface surface = EGL_NO_SURFACE;
+  const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context")) {
+    const EGLint pbuffer_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    surface = eglCreatePbufferSurface(display, config, pbuffer_attributes);
+    if (surface == EGL_NO_SURFACE)
+      throw std::runtime_error("Failed to create EGL pbuffer.");
+    EglSurface = surface;
+  }
+  if (!eglMakeCurrent(display, surface, surface, context))
+    throw std::runtime_error("Failed to make EGL context current.");
+#else
+  throw std::runtime_error("EGL is only used on Linux.");
+#endif
+}
+
+void Engine::setupHeadless() {
+#ifdef __linux__
+  setupEGL();
+#else
+  glfwSetErrorCallback(glfw_error_callback);
+  if (!glfwInit()) {
+    throw std::runtime_error("Failed to initialize GLFW.");
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, GlMajor);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, GlMinor);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  Fullscreen = 0;
+  setupWindow();
+  glfwSwapInterval(0);
+#endif
+}
+
 void Engine::setupGLEW() {
   glewExperimental = GL_TRUE;
   // Allow extension entry points to be loaded even if the extension isn't
@@ -139,13 +300,14 @@ void Engine::setupGLEW() {
 
 void Engine::setupOpenGL() {
   glClearColor(0.02f, 0.02f, 0.03f, 1.0f); // background color
-  glEnable(GL_DEPTH_TEST);
-  glDepthFunc(GL_LEQUAL);
-  glDepthMask(GL_TRUE);
+  StateCache &cache = StateCache::getInstance();
+  cache.setEnabled(GL_DEPTH_TEST, true);
+  cache.depthFunc(GL_LEQUAL);
+  cache.depthMask(GL_TRUE);
   glDepthRange(0.0, 1.0);
   glClearDepth(1.0);
-  //glEnable(GL_CULL_FACE);
-  glCullFace(GL_BACK);
+  //cache.setEnabled(GL_CULL_FACE, true);
+  cache.cullFace(GL_BACK);
   glFrontFace(GL_CCW);
   glViewport(0, 0, WindowWidth, WindowHeight);
 }
@@ -162,9 +324,17 @@ void displayInfo() {
 }
 
 void Engine::init() {
-  setupGLFW();
+  if (Headless)
+    setupHeadless();
+  else
+    setupGLFW();
   setupGLEW();
   setupOpenGL();
+  if (Headless) {
+    Target = new Framebuffer();
+    Target->create(WindowWidth, WindowHeight);
+    Target->bind();
+  }
   GlApp->initCallback(Window);
 #ifdef DEBUG
   displayInfo();
@@ -174,27 +344,168 @@ void Engine::init() {
 
 //////////////////////////////////////////////////////////////////////////// RUN
 
+// The tolerance keeps a frame time equal to the step (e.g. headless frames
+// at the simulation rate) from rounding down to zero steps.
+void Engine::update(double elapsed) {
+  Accumulator += elapsed;
+  const double tolerance = FixedStep * 1e-6;
+  int steps = 0;
+  while (Accumulator + tolerance >= FixedStep && steps < MaxSteps) {
+    GlApp->updateCallback(Window, FixedStep);
+    Accumulator = std::max(Accumulator - FixedStep, 0.0);
+    SimulationTime = SimulationTime + FixedStep;
+    steps++;
+  }
+  if (Accumulator >= FixedStep)
+    Accumulator = std::fmod(Accumulator, FixedStep);
+}
+
+// Steps are scheduled on an absolute clock so that sleep jitter does not
+// accumulate. Falling more than MaxSteps behind drops the backlog, as
+// update() does.
+void Engine::updateLoop() {
+  typedef std::chrono::steady_clock clock;
+  Profiler::getInstance().setThreadName("Update");
+  const clock::duration step = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(FixedStep));
+  clock::time_point next = clock::now();
+  try {
+    while (UpdateRunning) {
+      GlApp->updateCallback(Window, FixedStep);
+      SimulationTime = SimulationTime + FixedStep;
+      next += step;
+      const clock::time_point now = clock::now();
+      if (now - next > step * MaxSteps)
+        next = now;
+      else
+        std::this_thread::sleep_until(next);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "UPDATE EXCEPTION: " << e.what() << std::endl;
+  }
+}
+
+void Engine::stopUpdateThread() {
+  UpdateRunning = false;
+  if (UpdateThread.joinable())
+    UpdateThread.join();
+}
+
+// Sleeps until a millisecond before the deadline and spins the rest, as
+// sleeps overshoot. A frame that misses its deadline by more than an
+// interval restarts the schedule instead of rushing the frames after it.
+void Engine::present() {
+  typedef std::chrono::steady_clock clock;
+  if (PacingInterval > 0.0) {
+    const clock::duration interval =
+        std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(PacingInterval));
+    NextPresent += interval;
+    if (clock::now() - NextPresent > interval) {
+      NextPresent = clock::now();
+    } else {
+      std::this_thread::sleep_until(NextPresent - std::chrono::milliseconds(1));
+      while (clock::now() < NextPresent)
+        std::this_thread::yield();
+    }
+  }
+  glfwSwapBuffers(Window);
+  const clock::time_point now = clock::now();
+  if (Presented)
+    Profiler::getInstance().addSample(
+        "Present interval",
+        std::chrono::duration<double, std::milli>(now - LastPresent).count());
+  LastPresent = now;
+  Presented = true;
+}
+
 void Engine::run() {
+  if (Headless) {
+    runHeadless();
+    return;
+  }
+  Profiler &profiler = Profiler::getInstance();
+  if (Threaded) {
+    UpdateRunning = true;
+    UpdateThread = std::thread(&Engine::updateLoop, this);
+  }
   double last_time = glfwGetTime();
   while (!glfwWindowShouldClose(Window)) {
     try {
+      profiler.beginFrame();
       double time = glfwGetTime();
       double elapsed_time = time - last_time;
       last_time = time;
+      if (!Threaded)
+        update(elapsed_time);
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
               GL_STENCIL_BUFFER_BIT);
       GlApp->displayCallback(Window, elapsed_time);
-      glfwSwapBuffers(Window);
+      StateCache::getInstance().endFrame();
+      GLRecorder::getInstance().endFrame();
+      present();
+      profiler.endFrame();
       glfwPollEvents();
     } catch (const std::exception &e) {
       std::cerr << "FRAME EXCEPTION: " << e.what() << std::endl;
       glfwSetWindowShouldClose(Window, GLFW_TRUE);
     }
   }
+  stopUpdateThread();
+  profiler.destroyGpuTimers();
   glfwDestroyWindow(Window);
   Window = nullptr;
   glfwTerminate();
 }
 
+// Every frame advances exactly one timestep, so runs are reproducible.
+void Engine::runHeadless() {
+  Profiler &profiler = Profiler::getInstance();
+  for (int frame = 0; frame < HeadlessFrames; frame++) {
+    try {
+      profiler.beginFrame();
+      update(Timestep);
+      Target->bind();
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
+              GL_STENCIL_BUFFER_BIT);
+      GlApp->displayCallback(Window, Timestep);
+      StateCache::getInstance().endFrame();
+      GLRecorder::getInstance().endFrame();
+      if (!DumpPrefix.empty()) {
+        std::ostringstream filename;
+        filename << DumpPrefix << std::setw(4) << std::setfill('0') << frame
+                 << ".ppm";
+        Target->savePPM(filename.str());
+      }
+      profiler.endFrame();
+    } catch (const std::exception &e) {
+      std::cerr << "FRAME EXCEPTION: " << e.what() << std::endl;
+      break;
+    }
+  }
+  glFinish();
+  GlApp->windowCloseCallback(Window);
+  profiler.destroyGpuTimers();
+  delete Target;
+  Target = nullptr;
+  destroyContext();
+}
+
+void Engine::destroyContext() {
+#ifdef __linux__
+  EGLDisplay display = static_cast<EGLDisplay>(EglDisplay);
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (EglSurface)
+    eglDestroySurface(display, static_cast<EGLSurface>(EglSurface));
+  eglDestroyContext(display, static_cast<EGLContext>(EglContext));
+  eglTerminate(display);
+  EglDisplay = EglContext = EglSurface = nullptr;
+#else
+  glfwDestroyWindow(Window);
+  Window = nullptr;
+  glfwTerminate();
+#endif
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 } // namespace mgl
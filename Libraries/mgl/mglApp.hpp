@@ -12,19 +12,28 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/ext.hpp>
+#include <atomic>
 #include <glm/glm.hpp>
+#include <string>
+#include <thread>
 
 namespace mgl {
 
 class App;
 class Engine;
+class Framebuffer;
 
 //////////////////////////////////////////////////////////////////////////// App
 
+// In headless mode there may be no window: callbacks receive nullptr.
+
 class App {
 public:
   virtual void initCallback(GLFWwindow *window) {}
   virtual void displayCallback(GLFWwindow *window, double elapsed) {}
+  // Called zero or more times before each frame, always with the fixed step.
+  // With a threaded update it runs on the update thread instead (no GL).
+  virtual void updateCallback(GLFWwindow *window, double timestep) {}
   virtual void windowCloseCallback(GLFWwindow *window) {}
   virtual void windowSizeCallback(GLFWwindow *window, int width, int height) {}
   virtual void cursorCallback(GLFWwindow *window, double xpos, double ypos) {}
@@ -53,6 +62,42 @@ public:
   void setOpenGL(int major, int minor);
   void setWindow(int width, int height, const char *title, int fullscreen,
                  int vsync);
+  // Simulation runs in fixed steps (default 60 Hz) from an accumulator of
+  // frame time, independently of the frame rate. At most max_steps run per
+  // frame; time beyond that is dropped so that a slow frame cannot snowball.
+  void setFixedTimestep(double timestep, int max_steps);
+  double getFixedTimestep() const;
+  // Fraction of a step accumulated but not yet simulated, in [0,1): render
+  // state can be interpolated (or extrapolated) by alpha * timestep. Always
+  // 0 with a threaded update, where the app measures its own snapshot age.
+  double getInterpolationAlpha() const;
+  // Total simulated time (number of steps times the timestep).
+  double getSimulationTime() const;
+  // Runs updateCallback on its own thread, at the fixed step in real time,
+  // so that simulation and rendering of consecutive frames overlap. The app
+  // hands state to the renderer itself (e.g. with a TripleBuffer). Ignored
+  // in headless mode, which stays deterministic. Call before run().
+  void setThreadedUpdate(bool threaded);
+  bool isThreadedUpdate() const;
+  // Joins the update thread; run() and the window close both call it.
+  void stopUpdateThread();
+  // Presents frames at a steady interval in seconds (0, the default, turns
+  // it off) by waiting for each deadline before the swap, so that uneven
+  // frame times do not reach the screen. Either way every frame records its
+  // "Present interval" in the Profiler. Has no effect in headless mode.
+  void setFramePacing(double interval);
+  double getFramePacing() const;
+  // Renders the given number of frames offscreen, at the window size and
+  // with a fixed timestep, and then returns from run(). On Linux the context
+  // is an EGL surfaceless (or pbuffer) one and no display is needed;
+  // elsewhere a hidden GLFW window provides it. Call before init().
+  void setHeadless(int frames, double timestep);
+  // Headless frames are saved as <prefix>NNNN.ppm; an empty prefix saves none.
+  void setFrameDump(const std::string &prefix);
+  bool isHeadless() const;
+  // Headless render target (nullptr when rendering to a window).
+  Framebuffer *getFramebuffer();
+
   void init();
   void run();
 
@@ -67,12 +112,34 @@ private:
   int GlMajor, GlMinor;
   int Fullscreen;
   int Vsync;
+  double FixedStep, Accumulator;
+  std::atomic<double> SimulationTime;
+  int MaxSteps;
+  bool Threaded;
+  std::thread UpdateThread;
+  std::atomic<bool> UpdateRunning;
+  double PacingInterval;
+  std::chrono::steady_clock::time_point NextPresent, LastPresent;
+  bool Presented;
+  bool Headless;
+  int HeadlessFrames;
+  double Timestep;
+  std::string DumpPrefix;
+  Framebuffer *Target;
+  void *EglDisplay, *EglContext, *EglSurface;
 
   void setupWindow();
   void setupGLFW();
+  void setupHeadless();
+  void setupEGL();
+  void runHeadless();
+  void destroyContext();
   void setupGLEW();
   void setupOpenGL();
   void setupCallbacks();
+  void update(double elapsed);
+  void updateLoop();
+  void present();
 
 public:
   Engine(Engine const &) = delete;
@@ -0,0 +1,304 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Bounding Volume Hierarchy Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglBvh.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////////////////// Bvh
+
+const unsigned int Bvh::MAX_LEAF_SIZE;
+
+static const int SAH_BINS = 12;
+// Keeps the traversal stack bounded.
+static const int MAX_DEPTH = 60;
+
+static Bvh::Aabb emptyBox() {
+  const float inf = std::numeric_limits<float>::infinity();
+  Bvh::Aabb box = {glm::vec3(inf), glm::vec3(-inf)};
+  return box;
+}
+
+static void grow(Bvh::Aabb &box, const Bvh::Aabb &other) {
+  box.Min = glm::min(box.Min, other.Min);
+  box.Max = glm::max(box.Max, other.Max);
+}
+
+static float area(const Bvh::Aabb &box) {
+  const glm::vec3 d = box.Max - box.Min;
+  return d.x < 0.0f ? 0.0f : 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// Slab test; near is where the ray enters the box (0 if it starts inside).
+static bool intersectBox(const Bvh::Aabb &box, const Bvh::Ray &ray,
+                         const glm::vec3 &inv_direction, const float distance,
+                         float &near) {
+  const glm::vec3 t1 = (box.Min - ray.Origin) * inv_direction;
+  const glm::vec3 t2 = (box.Max - ray.Origin) * inv_direction;
+  const glm::vec3 tmin = glm::min(t1, t2);
+  const glm::vec3 tmax = glm::max(t1, t2);
+  near = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+  const float far = std::min(std::min(tmax.x, tmax.y), tmax.z);
+  return near <= far && near < distance;
+}
+
+void Bvh::clear() {
+  Nodes.clear();
+  Primitives.clear();
+}
+
+void Bvh::build(const std::vector<Aabb> &bounds) {
+  clear();
+  const unsigned int n = unsigned(bounds.size());
+  if (n == 0)
+    return;
+  std::vector<glm::vec3> centroids(n);
+  Node root = {emptyBox(), 0, n};
+  Primitives.resize(n);
+  for (unsigned int i = 0; i < n; i++) {
+    Primitives[i] = i;
+    centroids[i] = (bounds[i].Min + bounds[i].Max) * 0.5f;
+    grow(root.Box, bounds[i]);
+  }
+  Nodes.reserve(2 * n - 1);
+  Nodes.push_back(root);
+  subdivide(0, bounds, centroids);
+}
+
+// Splits a leaf along the binned SAH plane with the lowest cost, or in half
+// when a leaf with too many primitives would be cheaper (or cannot be binned).
+void Bvh::subdivide(const unsigned int node, const std::vector<Aabb> &bounds,
+                    const std::vector<glm::vec3> &centroids) {
+  struct Bin {
+    Aabb Box;
+    unsigned int Count;
+  };
+  struct Task {
+    unsigned int Node;
+    int Depth;
+  };
+  std::vector<Task> tasks(1, Task{node, 0});
+  while (!tasks.empty()) {
+    const Task task = tasks.back();
+    tasks.pop_back();
+    const unsigned int first = Nodes[task.Node].First;
+    const unsigned int count = Nodes[task.Node].Count;
+    if (count <= 1 || task.Depth >= MAX_DEPTH)
+      continue;
+
+    Aabb centroid_box = emptyBox();
+    for (unsigned int i = first; i < first + count; i++) {
+      const Aabb point = {centroids[Primitives[i]], centroids[Primitives[i]]};
+      grow(centroid_box, point);
+    }
+
+    int best_axis = -1, best_split = 0;
+    float best_cost = std::numeric_limits<float>::infinity();
+    for (int axis = 0; axis < 3; axis++) {
+      const float extent = centroid_box.Max[axis] - centroid_box.Min[axis];
+      if (extent <= 0.0f)
+        continue;
+      const float scale = SAH_BINS / extent;
+      Bin bins[SAH_BINS];
+      for (Bin &bin : bins) {
+        bin.Box = emptyBox();
+        bin.Count = 0;
+      }
+      for (unsigned int i = first; i < first + count; i++) {
+        const unsigned int p = Primitives[i];
+        const int b = std::min(
+            SAH_BINS - 1,
+            int((centroids[p][axis] - centroid_box.Min[axis]) * scale));
+        bins[b].Count++;
+        grow(bins[b].Box, bounds[p]);
+      }
+      // Cost of splitting after bin i: left sweep, then right sweep.
+      float left_area[SAH_BINS - 1];
+      unsigned int left_count[SAH_BINS - 1];
+      Aabb box = emptyBox();
+      unsigned int sum = 0;
+      for (int i = 0; i < SAH_BINS - 1; i++) {
+        grow(box, bins[i].Box);
+        sum += bins[i].Count;
+        left_area[i] = area(box);
+        left_count[i] = sum;
+      }
+      box = emptyBox();
+      sum = 0;
+      for (int i = SAH_BINS - 1; i > 0; i--) {
+        grow(box, bins[i].Box);
+        sum += bins[i].Count;
+        if (sum == 0 || left_count[i - 1] == 0)
+          continue;
+        const float cost = left_count[i - 1] * left_area[i - 1] +
+                           sum * area(box);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = axis;
+          best_split = i;
+        }
+      }
+    }
+
+    // One traversal step costs about as much as one primitive test.
+    const float parent_area = area(Nodes[task.Node].Box);
+    const float leaf_cost = float(count);
+    const float split_cost = 1.0f + best_cost / std::max(parent_area, 1e-20f);
+    if (count <= MAX_LEAF_SIZE && (best_axis < 0 || split_cost >= leaf_cost))
+      continue;
+
+    unsigned int *begin = Primitives.data() + first;
+    unsigned int *middle;
+    if (best_axis >= 0 && split_cost < leaf_cost) {
+      const float min = centroid_box.Min[best_axis];
+      const float scale =
+          SAH_BINS / (centroid_box.Max[best_axis] - centroid_box.Min[best_axis]);
+      middle = std::partition(begin, begin + count, [&](unsigned int p) {
+        return std::min(SAH_BINS - 1,
+                        int((centroids[p][best_axis] - min) * scale)) <
+               best_split;
+      });
+    } else {
+      const int axis = best_axis >= 0 ? best_axis : 0;
+      middle = begin + count / 2;
+      std::nth_element(begin, middle, begin + count,
+                       [&](unsigned int a, unsigned int b) {
+                         return centroids[a][axis] < centroids[b][axis];
+                       });
+    }
+
+    const unsigned int left_count = unsigned(middle - begin);
+    const unsigned int left = unsigned(Nodes.size());
+    Node children[2] = {{emptyBox(), first, left_count},
+                        {emptyBox(), first + left_count, count - left_count}};
+    for (Node &child : children) {
+      for (unsigned int i = child.First; i < child.First + child.Count; i++)
+        grow(child.Box, bounds[Primitives[i]]);
+      Nodes.push_back(child);
+    }
+    Nodes[task.Node].First = left;
+    Nodes[task.Node].Count = 0;
+    tasks.push_back(Task{left, task.Depth + 1});
+    tasks.push_back(Task{left + 1, task.Depth + 1});
+  }
+}
+
+// Children are always stored after their parent.
+void Bvh::refit(const std::vector<Aabb> &bounds) {
+  for (size_t i = Nodes.size(); i-- > 0;) {
+    Node &node = Nodes[i];
+    node.Box = emptyBox();
+    if (node.Count > 0) {
+      for (unsigned int p = node.First; p < node.First + node.Count; p++)
+        grow(node.Box, bounds[Primitives[p]]);
+    } else {
+      grow(node.Box, Nodes[node.First].Box);
+      grow(node.Box, Nodes[node.First + 1].Box);
+    }
+  }
+}
+
+// Front-to-back traversal: the nearer child is visited first so that boxes
+// beyond the closest hit found so far are skipped.
+int Bvh::raycast(const Ray &ray, const IntersectCallback &intersect,
+                 float &distance) const {
+  if (Nodes.empty())
+    return -1;
+  const glm::vec3 inv_direction = 1.0f / ray.Direction;
+  unsigned int stack[MAX_DEPTH + 4];
+  int top = 0;
+  float near;
+  if (intersectBox(Nodes[0].Box, ray, inv_direction, distance, near))
+    stack[top++] = 0;
+  int hit = -1;
+  while (top > 0) {
+    const Node &node = Nodes[stack[--top]];
+    if (!intersectBox(node.Box, ray, inv_direction, distance, near))
+      continue;
+    if (node.Count > 0) {
+      for (unsigned int i = node.First; i < node.First + node.Count; i++) {
+        const float t = intersect(Primitives[i], ray, distance);
+        if (t >= 0.0f && t < distance) {
+          distance = t;
+          hit = int(Primitives[i]);
+        }
+      }
+      continue;
+    }
+    float near_left, near_right;
+    const bool left = intersectBox(Nodes[node.First].Box, ray, inv_direction,
+                                   distance, near_left);
+    const bool right = intersectBox(Nodes[node.First + 1].Box, ray,
+                                    inv_direction, distance, near_right);
+    if (left && right) {
+      const bool left_first = near_left <= near_right;
+      stack[top++] = left_first ? node.First + 1 : node.First;
+      stack[top++] = left_first ? node.First : node.First + 1;
+    } else if (left) {
+      stack[top++] = node.First;
+    } else if (right) {
+      stack[top++] = node.First + 1;
+    }
+  }
+  return hit;
+}
+
+void Bvh::collect(const unsigned int node,
+                  std::vector<unsigned int> &result) const {
+  const Node &n = Nodes[node];
+  if (n.Count > 0) {
+    result.insert(result.end(), Primitives.begin() + n.First,
+                  Primitives.begin() + n.First + n.Count);
+  } else {
+    collect(n.First, result);
+    collect(n.First + 1, result);
+  }
+}
+
+// Subtrees inside the frustum are taken whole; leaves that intersect it are
+// taken without testing their primitives.
+void Bvh::query(const Frustum &frustum,
+                std::vector<unsigned int> &result) const {
+  if (Nodes.empty())
+    return;
+  unsigned int stack[MAX_DEPTH + 4];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const unsigned int index = stack[--top];
+    const Node &node = Nodes[index];
+    const Frustum::Result test = frustum.testAabb(node.Box.Min, node.Box.Max);
+    if (test == Frustum::OUTSIDE)
+      continue;
+    if (test == Frustum::INSIDE || node.Count > 0) {
+      collect(index, result);
+    } else {
+      stack[top++] = node.First;
+      stack[top++] = node.First + 1;
+    }
+  }
+}
+
+// Box around the transformed box (Arvo): center plus the absolute linear
+// part applied to the half extents.
+Bvh::Aabb Bvh::transform(const Aabb &box, const glm::mat4 &matrix) {
+  const glm::vec3 center = (box.Min + box.Max) * 0.5f;
+  const glm::vec3 extent = (box.Max - box.Min) * 0.5f;
+  const glm::vec3 c = glm::vec3(matrix * glm::vec4(center, 1.0f));
+  glm::vec3 e(0.0f);
+  for (int col = 0; col < 3; col++)
+    e += glm::abs(glm::vec3(matrix[col])) * extent[col];
+  Aabb result = {c - e, c + e};
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
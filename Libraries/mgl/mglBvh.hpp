@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Bounding Volume Hierarchy Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_BVH_HPP
+#define MGL_BVH_HPP
+
+#include <functional>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "./mglFrustum.hpp"
+
+namespace mgl {
+
+class Bvh;
+
+//////////////////////////////////////////////////////////////////////////// Bvh
+
+// Binary AABB tree over primitives given only by their bounds, built with a
+// binned surface area heuristic. When primitives move without changing much,
+// refit() updates the boxes bottom-up and keeps the tree topology.
+
+class Bvh final {
+public:
+  struct Aabb {
+    glm::vec3 Min, Max;
+  };
+
+  // Hit distances are in units of Direction, which need not be normalized.
+  struct Ray {
+    glm::vec3 Origin, Direction;
+  };
+
+  // Returns the hit distance with a primitive, or a negative value if the
+  // primitive is missed or only hit beyond max_distance.
+  typedef std::function<float(const unsigned int primitive, const Ray &ray,
+                              const float max_distance)>
+      IntersectCallback;
+
+  static const unsigned int MAX_LEAF_SIZE = 4;
+
+  void build(const std::vector<Aabb> &bounds);
+  void refit(const std::vector<Aabb> &bounds);
+  void clear();
+
+  // Closest primitive hit within distance (updated on a hit), or -1.
+  int raycast(const Ray &ray, const IntersectCallback &intersect,
+              float &distance) const;
+  // Primitives whose boxes are not outside the frustum.
+  void query(const Frustum &frustum, std::vector<unsigned int> &result) const;
+
+  bool empty() const { return Nodes.empty(); }
+  size_t getNodeCount() const { return Nodes.size(); }
+  const Aabb &getBounds() const { return Nodes[0].Box; }
+
+  static Aabb transform(const Aabb &box, const glm::mat4 &matrix);
+
+private:
+  // Leaves hold Count primitives from First; inner nodes have Count == 0
+  // and their children at First and First + 1.
+  struct Node {
+    Aabb Box;
+    unsigned int First, Count;
+  };
+  std::vector<Node> Nodes;
+  std::vector<unsigned int> Primitives;
+
+  void subdivide(const unsigned int node, const std::vector<Aabb> &bounds,
+                 const std::vector<glm::vec3> &centroids);
+  void collect(const unsigned int node,
+               std::vector<unsigned int> &result) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_BVH_HPP */
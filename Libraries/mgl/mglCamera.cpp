@@ -8,25 +8,48 @@
 
 #include "./mglCamera.hpp"
 
+#include <cstring>
+#include <stdexcept>
+
+#include "./mglStateCache.hpp"
+
+
 namespace mgl {
 
 ///////////////////////////////////////////////////////////////////////// Camera
 
+const int Camera::RING;
+
 Camera::Camera(GLuint bindingpoint)
-    : ViewMatrix(glm::mat4(1.0f)), ProjectionMatrix(glm::mat4(1.0f)) {
+    : BindingPoint(bindingpoint), ViewMatrix(glm::mat4(1.0f)),
+      ProjectionMatrix(glm::mat4(1.0f)), Dirty(true), Current(RING - 1) {
+  GLint alignment = 256;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  const GLsizeiptr block = sizeof(glm::mat4) * 2;
+  SlotSize = (block + alignment - 1) / alignment * alignment;
+  for (int i = 0; i < RING; i++)
+    Fences[i] = 0;
+
+  const GLbitfield flags =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
   glGenBuffers(1, &UboId);
-  glBindBuffer(GL_UNIFORM_BUFFER, UboId);
-  glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4) * 2, 0, GL_STREAM_DRAW);
-  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4),
-                  glm::value_ptr(ViewMatrix));
-  glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4),
-                  glm::value_ptr(ProjectionMatrix));
-  glBindBufferBase(GL_UNIFORM_BUFFER, bindingpoint, UboId);
-  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  StateCache::getInstance().bindBuffer(GL_UNIFORM_BUFFER, UboId);
+  glBufferStorage(GL_UNIFORM_BUFFER, SlotSize * RING, nullptr, flags);
+  Mapped = static_cast<unsigned char *>(
+      glMapBufferRange(GL_UNIFORM_BUFFER, 0, SlotSize * RING, flags));
+  if (!Mapped)
+    throw std::runtime_error("Cannot map the camera uniform buffer.");
+  flush();
 }
 
 Camera::~Camera() {
-  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  for (int i = 0; i < RING; i++)
+    if (Fences[i])
+      glDeleteSync(Fences[i]);
+  StateCache &cache = StateCache::getInstance();
+  cache.bindBuffer(GL_UNIFORM_BUFFER, UboId);
+  glUnmapBuffer(GL_UNIFORM_BUFFER);
+  cache.bindBuffer(GL_UNIFORM_BUFFER, 0);
   glDeleteBuffers(1, &UboId);
 }
 
@@ -34,20 +57,40 @@ glm::mat4 Camera::getViewMatrix() const { return ViewMatrix; }
 
 void Camera::setViewMatrix(const glm::mat4 &viewmatrix) {
   ViewMatrix = viewmatrix;
-  glBindBuffer(GL_UNIFORM_BUFFER, UboId);
-  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4),
-                  glm::value_ptr(ViewMatrix));
-  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  Dirty = true;
 }
 
 glm::mat4 Camera::getProjectionMatrix() const { return ProjectionMatrix; }
 
 void Camera::setProjectionMatrix(const glm::mat4 &projectionmatrix) {
   ProjectionMatrix = projectionmatrix;
-  glBindBuffer(GL_UNIFORM_BUFFER, UboId);
-  glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4),
-                  glm::value_ptr(ProjectionMatrix));
-  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  Dirty = true;
+}
+
+void Camera::flush() {
+  if (!Dirty)
+    return;
+  // Everything issued so far may read the current slot.
+  Fences[Current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  Current = (Current + 1) % RING;
+  if (Fences[Current]) {
+    while (glClientWaitSync(Fences[Current], GL_SYNC_FLUSH_COMMANDS_BIT,
+                            1000000) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(Fences[Current]);
+    Fences[Current] = 0;
+  }
+
+  // Coherent mapping: the writes are visible to the commands issued next.
+  unsigned char *slot = Mapped + SlotSize * Current;
+  std::memcpy(slot, glm::value_ptr(ViewMatrix), sizeof(glm::mat4));
+  std::memcpy(slot + sizeof(glm::mat4), glm::value_ptr(ProjectionMatrix),
+              sizeof(glm::mat4));
+  // glBindBufferRange also binds the generic GL_UNIFORM_BUFFER target.
+  StateCache::getInstance().bindBuffer(GL_UNIFORM_BUFFER, UboId);
+  glBindBufferRange(GL_UNIFORM_BUFFER, BindingPoint, UboId,
+                    SlotSize * Current, sizeof(glm::mat4) * 2);
+  Dirty = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -19,11 +19,26 @@ class Camera;
 
 ///////////////////////////////////////////////////////////////////////// Camera
 
+// The setters only mark the matrices dirty. flush() writes both, once per
+// frame, into the next slot of a ring in a persistently mapped uniform
+// buffer and binds that range, so a block the GPU may still be reading is
+// never overwritten. A slot is fenced when the camera moves past it and
+// waited on before it is reused, which only blocks if the GPU is RING
+// flushes behind.
+
 class Camera {
 private:
+  static const int RING = 3;
+
   GLuint UboId;
+  GLuint BindingPoint;
   glm::mat4 ViewMatrix;
   glm::mat4 ProjectionMatrix;
+  bool Dirty;
+  GLsizeiptr SlotSize;
+  unsigned char *Mapped;
+  GLsync Fences[RING];
+  int Current;
 
 public:
   explicit Camera(GLuint bindingpoint);
@@ -32,6 +47,9 @@ public:
   void setViewMatrix(const glm::mat4 &viewmatrix);
   glm::mat4 getProjectionMatrix() const;
   void setProjectionMatrix(const glm::mat4 &projectionmatrix);
+  // Uploads the matrices if they changed; call once per frame before drawing.
+  void flush();
+  bool isDirty() const { return Dirty; }
 };
 
 ////////////////////////////////////////////////////////////////////////////////
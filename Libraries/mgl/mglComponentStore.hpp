@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Component Store Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_COMPONENT_STORE_HPP
+#define MGL_COMPONENT_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mgl {
+
+template <typename T> class ComponentStore;
+
+///////////////////////////////////////////////////////////////// ComponentStore
+
+// Sparse set of components of one type, keyed by entity index (e.g. a Pool
+// slot). Components are packed in a dense array, so a system that needs
+// only this component iterates it linearly without touching the others.
+// Removal moves the last component into the hole: dense order is not
+// stable across add/remove.
+
+template <typename T> class ComponentStore final {
+public:
+  static const uint32_t NONE = ~0u;
+
+  void reserve(const size_t capacity) {
+    Entities.reserve(capacity);
+    Components.reserve(capacity);
+  }
+
+  // Replaces the component if the entity already has one.
+  T &add(const uint32_t entity, const T &value = T()) {
+    if (entity >= Sparse.size())
+      Sparse.resize(entity + 1, NONE);
+    uint32_t &slot = Sparse[entity];
+    if (slot != NONE) {
+      Components[slot] = value;
+    } else {
+      slot = uint32_t(Components.size());
+      Entities.push_back(entity);
+      Components.push_back(value);
+    }
+    return Components[slot];
+  }
+
+  bool remove(const uint32_t entity) {
+    if (!has(entity))
+      return false;
+    const uint32_t slot = Sparse[entity];
+    const uint32_t last = uint32_t(Components.size()) - 1;
+    if (slot != last) {
+      Components[slot] = Components[last];
+      Entities[slot] = Entities[last];
+      Sparse[Entities[slot]] = slot;
+    }
+    Components.pop_back();
+    Entities.pop_back();
+    Sparse[entity] = NONE;
+    return true;
+  }
+
+  void clear() {
+    Sparse.clear();
+    Entities.clear();
+    Components.clear();
+  }
+
+  bool has(const uint32_t entity) const {
+    return entity < Sparse.size() && Sparse[entity] != NONE;
+  }
+
+  T *get(const uint32_t entity) {
+    return has(entity) ? &Components[Sparse[entity]] : nullptr;
+  }
+  const T *get(const uint32_t entity) const {
+    return has(entity) ? &Components[Sparse[entity]] : nullptr;
+  }
+
+  // Dense access for linear passes: component i belongs to getEntity(i).
+  T &operator[](const size_t index) { return Components[index]; }
+  const T &operator[](const size_t index) const { return Components[index]; }
+  uint32_t getEntity(const size_t index) const { return Entities[index]; }
+
+  size_t size() const { return Components.size(); }
+  bool empty() const { return Components.empty(); }
+
+private:
+  std::vector<uint32_t> Sparse;
+  std::vector<uint32_t> Entities;
+  std::vector<T> Components;
+};
+
+template <typename T> const uint32_t ComponentStore<T>::NONE;
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_COMPONENT_STORE_HPP */
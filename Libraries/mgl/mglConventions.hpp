@@ -26,6 +26,8 @@ const char TEXCOORD_ATTRIBUTE[] = "inTexcoord";
 const char TANGENT_ATTRIBUTE[] = "inTangent";
 const char BITANGENT_ATTRIBUTE[] = "inBitangent";
 const char COLOR_ATTRIBUTE[] = "inColor";
+const char INSTANCE_MATRIX_ATTRIBUTE[] = "inInstanceMatrix";
+const char INSTANCE_MATERIAL_ATTRIBUTE[] = "inInstanceMaterial";
 
 ////////////////////////////////////////////////////////////////////////////////
 } // namespace mgl
@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Dynamic Resolution Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglDynamicResolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////// DynamicResolution
+
+const int DynamicResolution::GPU_LATENCY;
+constexpr float DynamicResolution::STEP;
+constexpr double DynamicResolution::HEADROOM;
+constexpr double DynamicResolution::GAIN;
+
+DynamicResolution::DynamicResolution()
+    : Current(0), Created(false), Target(16.6), GpuTime(0.0), Scale(1.0f),
+      Applied(1.0f), MinScale(0.5f), MaxScale(1.0f), Width(0), Height(0) {
+  for (int i = 0; i < GPU_LATENCY; i++)
+    Pending[i] = false;
+}
+
+DynamicResolution::~DynamicResolution() { destroy(); }
+
+void DynamicResolution::setTarget(const double ms) {
+  if (ms <= 0.0)
+    throw std::runtime_error("Invalid dynamic resolution target.");
+  Target = ms;
+}
+
+void DynamicResolution::setScaleRange(const float min, const float max) {
+  if (min <= 0.0f || min > max || max > 1.0f)
+    throw std::runtime_error("Invalid dynamic resolution scale range.");
+  MinScale = min;
+  MaxScale = max;
+  Scale = std::min(std::max(Scale, MinScale), MaxScale);
+  Applied = std::min(std::max(Applied, MinScale), MaxScale);
+}
+
+GLsizei DynamicResolution::getRenderWidth() const {
+  return std::max(GLsizei(std::lround(Width * Applied)), GLsizei(1));
+}
+
+GLsizei DynamicResolution::getRenderHeight() const {
+  return std::max(GLsizei(std::lround(Height * Applied)), GLsizei(1));
+}
+
+void DynamicResolution::begin(const GLsizei width, const GLsizei height) {
+  if (!Created) {
+    glGenQueries(2 * GPU_LATENCY, &Queries[0][0]);
+    Created = true;
+  }
+  Buffer.create(width, height);
+  Width = width;
+  Height = height;
+  Buffer.bind();
+  glViewport(0, 0, getRenderWidth(), getRenderHeight());
+  // a slot still in flight is read (and waited for) before reuse
+  if (Pending[Current])
+    collect(Current);
+  glQueryCounter(Queries[Current][0], GL_TIMESTAMP);
+}
+
+void DynamicResolution::end(const GLuint framebuffer) {
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, Buffer.getId());
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+  glBlitFramebuffer(0, 0, getRenderWidth(), getRenderHeight(), 0, 0, Width,
+                    Height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glViewport(0, 0, Width, Height);
+  glQueryCounter(Queries[Current][1], GL_TIMESTAMP);
+  Pending[Current] = true;
+  Current = (Current + 1) % GPU_LATENCY;
+  collect(-1);
+}
+
+// Results complete in order: read from the oldest and stop at the first one
+// that is not available yet, unless it is the slot that must be read.
+void DynamicResolution::collect(const int required) {
+  for (int i = 0; i < GPU_LATENCY; i++) {
+    const int index = (Current + i) % GPU_LATENCY;
+    if (!Pending[index])
+      continue;
+    GLuint ready = GL_FALSE;
+    glGetQueryObjectuiv(Queries[index][1], GL_QUERY_RESULT_AVAILABLE, &ready);
+    if (!ready && index != required)
+      break;
+    GLuint64 start = 0, stop = 0;
+    glGetQueryObjectui64v(Queries[index][0], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(Queries[index][1], GL_QUERY_RESULT, &stop);
+    Pending[index] = false;
+    if (stop > start)
+      adjust(double(stop - start) / 1e6);
+  }
+}
+
+// GPU time grows with the pixel count, i.e. with the square of the scale.
+void DynamicResolution::adjust(const double ms) {
+  GpuTime = ms;
+  const double desired = Scale * std::sqrt(Target * HEADROOM / ms);
+  Scale = float(Scale + (desired - Scale) * GAIN);
+  Scale = std::min(std::max(Scale, MinScale), MaxScale);
+  const float steps = std::round((Scale - MinScale) / STEP);
+  Applied = std::min(MinScale + steps * STEP, MaxScale);
+}
+
+void DynamicResolution::destroy() {
+  if (Created) {
+    glDeleteQueries(2 * GPU_LATENCY, &Queries[0][0]);
+    Created = false;
+  }
+  for (int i = 0; i < GPU_LATENCY; i++)
+    Pending[i] = false;
+  Current = 0;
+  Buffer.destroy();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
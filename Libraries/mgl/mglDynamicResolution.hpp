@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Dynamic Resolution Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_DYNAMIC_RESOLUTION_HPP
+#define MGL_DYNAMIC_RESOLUTION_HPP
+
+#include <GL/glew.h>
+
+#include "./mglFramebuffer.hpp"
+
+namespace mgl {
+
+class DynamicResolution;
+
+////////////////////////////////////////////////////////////// DynamicResolution
+
+// Renders a frame into the lower-left part of an offscreen framebuffer and
+// upscales it to the output with a bilinear blit. The part covers a scale of
+// the output size that follows the GPU time between begin() and end(): the
+// pixel count is scaled by target / measured, damped and aiming slightly
+// below the target so that noise does not push frames over it. The scale is
+// applied in steps, so that small corrections do not resize anything that
+// depends on the render size. GPU times are timestamp queries read
+// GPU_LATENCY frames late, which leaves the Profiler's GPU scopes free.
+
+class DynamicResolution final {
+public:
+  static const int GPU_LATENCY = 4;
+  static constexpr float STEP = 0.05f;
+  static constexpr double HEADROOM = 0.9;
+  static constexpr double GAIN = 0.25;
+
+  DynamicResolution();
+  ~DynamicResolution();
+  DynamicResolution(const DynamicResolution &) = delete;
+  DynamicResolution &operator=(const DynamicResolution &) = delete;
+
+  // GPU milliseconds per frame (default 16.6).
+  void setTarget(const double ms);
+  double getTarget() const { return Target; }
+  void setScaleRange(const float min, const float max);
+
+  // Binds the framebuffer with a viewport of the render size; the
+  // framebuffer follows the output size.
+  void begin(const GLsizei width, const GLsizei height);
+  // Upscales into the given framebuffer (0 for the window), restores the
+  // full viewport and updates the scale from any GPU time that came back.
+  void end(const GLuint framebuffer);
+  void destroy();
+
+  float getScale() const { return Applied; }
+  GLsizei getRenderWidth() const;
+  GLsizei getRenderHeight() const;
+  // Last GPU frame time measured, in milliseconds.
+  double getGpuTime() const { return GpuTime; }
+
+private:
+  Framebuffer Buffer;
+  GLuint Queries[GPU_LATENCY][2];
+  bool Pending[GPU_LATENCY];
+  int Current;
+  bool Created;
+  double Target, GpuTime;
+  float Scale, Applied, MinScale, MaxScale;
+  GLsizei Width, Height;
+
+  void collect(const int required);
+  void adjust(const double ms);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_DYNAMIC_RESOLUTION_HPP */
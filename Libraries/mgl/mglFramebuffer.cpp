@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Framebuffer Object Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglFramebuffer.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#include "./mglGpuMemory.hpp"
+#include "./mglStateCache.hpp"
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////////// Framebuffer
+
+const GLuint Framebuffer::TEXTURE_UNIT;
+
+Framebuffer::Framebuffer()
+    : Id(0), ColorTexture(0), DepthStencil(0), Width(0), Height(0) {}
+
+Framebuffer::~Framebuffer() { destroy(); }
+
+void Framebuffer::create(const GLsizei width, const GLsizei height) {
+  if (Id && width == Width && height == Height)
+    return;
+  destroy();
+  if (width <= 0 || height <= 0)
+    throw std::runtime_error("Invalid framebuffer size.");
+  Width = width;
+  Height = height;
+
+  StateCache &cache = StateCache::getInstance();
+  glGenTextures(1, &ColorTexture);
+  cache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, ColorTexture);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  glGenRenderbuffers(1, &DepthStencil);
+  glBindRenderbuffer(GL_RENDERBUFFER, DepthStencil);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  // RGBA8 color and DEPTH24_STENCIL8, 4 bytes per pixel each
+  GpuMemory::getInstance().allocate(GpuMemory::TEXTURES,
+                                    size_t(Width) * Height * 8);
+
+  glGenFramebuffers(1, &Id);
+  glBindFramebuffer(GL_FRAMEBUFFER, Id);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         ColorTexture, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, DepthStencil);
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    destroy();
+    throw std::runtime_error("Framebuffer is incomplete.");
+  }
+}
+
+void Framebuffer::destroy() {
+  if (ColorTexture && DepthStencil)
+    GpuMemory::getInstance().release(GpuMemory::TEXTURES,
+                                     size_t(Width) * Height * 8);
+  if (Id) {
+    glDeleteFramebuffers(1, &Id);
+    Id = 0;
+  }
+  if (ColorTexture) {
+    StateCache::getInstance().bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &ColorTexture);
+    ColorTexture = 0;
+  }
+  if (DepthStencil) {
+    glDeleteRenderbuffers(1, &DepthStencil);
+    DepthStencil = 0;
+  }
+  Width = Height = 0;
+}
+
+void Framebuffer::bind() {
+  glBindFramebuffer(GL_FRAMEBUFFER, Id);
+  glViewport(0, 0, Width, Height);
+}
+
+void Framebuffer::unbind() { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+
+void Framebuffer::readPixels(std::vector<unsigned char> &pixels) {
+  pixels.resize(size_t(Width) * Height * 3);
+  GLint previous = 0;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, Id);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, Width, Height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(previous));
+}
+
+void Framebuffer::savePPM(const std::string &filename) {
+  readPixels(Pixels);
+  std::ofstream file(filename, std::ios::binary);
+  if (!file)
+    throw std::runtime_error("Cannot write " + filename);
+  file << "P6\n" << Width << " " << Height << "\n255\n";
+  const size_t row = size_t(Width) * 3;
+  for (GLsizei y = Height; y-- > 0;)
+    file.write(reinterpret_cast<const char *>(&Pixels[y * row]), row);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
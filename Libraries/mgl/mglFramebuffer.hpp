@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Framebuffer Object Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_FRAMEBUFFER_HPP
+#define MGL_FRAMEBUFFER_HPP
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+
+namespace mgl {
+
+class Framebuffer;
+
+//////////////////////////////////////////////////////////////////// Framebuffer
+
+// Offscreen render target with an RGBA8 color texture and a depth-stencil
+// renderbuffer, laid out like the default framebuffer so that a scene can
+// be drawn into it unchanged.
+
+class Framebuffer final {
+public:
+  static const GLuint TEXTURE_UNIT = 0;
+
+  Framebuffer();
+  ~Framebuffer();
+  Framebuffer(const Framebuffer &) = delete;
+  Framebuffer &operator=(const Framebuffer &) = delete;
+
+  // (Re)allocates the attachments; a no-op if the size is unchanged.
+  void create(const GLsizei width, const GLsizei height);
+  void destroy();
+
+  // Binds for drawing and reading and sets the viewport to the full size.
+  void bind();
+  static void unbind();
+
+  // Tightly packed RGB rows, bottom row first (as read by OpenGL).
+  void readPixels(std::vector<unsigned char> &pixels);
+  // Binary PPM (P6), top row first.
+  void savePPM(const std::string &filename);
+
+  GLuint getId() const { return Id; }
+  GLuint getColorTexture() const { return ColorTexture; }
+  GLsizei getWidth() const { return Width; }
+  GLsizei getHeight() const { return Height; }
+
+private:
+  GLuint Id, ColorTexture, DepthStencil;
+  GLsizei Width, Height;
+  std::vector<unsigned char> Pixels;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_FRAMEBUFFER_HPP */
@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// View Frustum Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglFrustum.hpp"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) ||                                     \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MGL_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////////////// Frustum
+
+Frustum::Frustum() { update(glm::mat4(1.0f)); }
+
+Frustum::Frustum(const glm::mat4 &view_projection) { update(view_projection); }
+
+// Gribb-Hartmann: each plane is the last row of the matrix plus or minus
+// one of the others (glm matrices are column-major).
+void Frustum::update(const glm::mat4 &view_projection) {
+  const glm::mat4 m = glm::transpose(view_projection);
+  const glm::vec4 planes[PLANES] = {m[3] + m[0], m[3] - m[0], m[3] + m[1],
+                                    m[3] - m[1], m[3] + m[2], m[3] - m[2]};
+  for (int i = 0; i < 8; i++) {
+    // Lanes past the sixth plane repeat the first one.
+    const glm::vec4 &p = planes[i < PLANES ? i : 0];
+    const float length = glm::length(glm::vec3(p));
+    Nx[i] = p.x / length;
+    Ny[i] = p.y / length;
+    Nz[i] = p.z / length;
+    D[i] = p.w / length;
+  }
+}
+
+Frustum::Result Frustum::testSphere(const glm::vec3 &center,
+                                    const float radius) const {
+#ifdef MGL_FRUSTUM_SSE
+  const __m128 cx = _mm_set1_ps(center.x);
+  const __m128 cy = _mm_set1_ps(center.y);
+  const __m128 cz = _mm_set1_ps(center.z);
+  const __m128 r = _mm_set1_ps(radius);
+  const __m128 neg_r = _mm_set1_ps(-radius);
+  int outside = 0, inside = 0;
+  for (int i = 0; i < 8; i += 4) {
+    __m128 dist = _mm_add_ps(_mm_mul_ps(_mm_load_ps(Nx + i), cx),
+                             _mm_mul_ps(_mm_load_ps(Ny + i), cy));
+    dist = _mm_add_ps(dist, _mm_mul_ps(_mm_load_ps(Nz + i), cz));
+    dist = _mm_add_ps(dist, _mm_load_ps(D + i));
+    outside |= _mm_movemask_ps(_mm_cmplt_ps(dist, neg_r));
+    inside |= _mm_movemask_ps(_mm_cmpge_ps(dist, r)) << i;
+  }
+  if (outside)
+    return OUTSIDE;
+  return inside == 0xff ? INSIDE : INTERSECTING;
+#else
+  Result result = INSIDE;
+  for (int i = 0; i < PLANES; i++) {
+    const float dist =
+        Nx[i] * center.x + Ny[i] * center.y + Nz[i] * center.z + D[i];
+    if (dist < -radius)
+      return OUTSIDE;
+    if (dist < radius)
+      result = INTERSECTING;
+  }
+  return result;
+#endif
+}
+
+// Distance of the AABB center plus or minus its projected half extent.
+Frustum::Result Frustum::testAabb(const glm::vec3 &min,
+                                  const glm::vec3 &max) const {
+  const glm::vec3 c = (min + max) * 0.5f;
+  const glm::vec3 e = (max - min) * 0.5f;
+#ifdef MGL_FRUSTUM_SSE
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  int outside = 0, inside = 0;
+  for (int i = 0; i < 8; i += 4) {
+    const __m128 nx = _mm_load_ps(Nx + i);
+    const __m128 ny = _mm_load_ps(Ny + i);
+    const __m128 nz = _mm_load_ps(Nz + i);
+    __m128 dist = _mm_add_ps(_mm_mul_ps(nx, _mm_set1_ps(c.x)),
+                             _mm_mul_ps(ny, _mm_set1_ps(c.y)));
+    dist = _mm_add_ps(dist, _mm_mul_ps(nz, _mm_set1_ps(c.z)));
+    dist = _mm_add_ps(dist, _mm_load_ps(D + i));
+    __m128 extent = _mm_mul_ps(_mm_andnot_ps(sign, nx), _mm_set1_ps(e.x));
+    extent = _mm_add_ps(
+        extent, _mm_mul_ps(_mm_andnot_ps(sign, ny), _mm_set1_ps(e.y)));
+    extent = _mm_add_ps(
+        extent, _mm_mul_ps(_mm_andnot_ps(sign, nz), _mm_set1_ps(e.z)));
+    outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, extent),
+                                            _mm_setzero_ps()));
+    inside |= _mm_movemask_ps(_mm_cmpge_ps(_mm_sub_ps(dist, extent),
+                                           _mm_setzero_ps()))
+              << i;
+  }
+  if (outside)
+    return OUTSIDE;
+  return inside == 0xff ? INSIDE : INTERSECTING;
+#else
+  Result result = INSIDE;
+  for (int i = 0; i < PLANES; i++) {
+    const float dist = Nx[i] * c.x + Ny[i] * c.y + Nz[i] * c.z + D[i];
+    const float extent = std::fabs(Nx[i]) * e.x + std::fabs(Ny[i]) * e.y +
+                         std::fabs(Nz[i]) * e.z;
+    if (dist + extent < 0.0f)
+      return OUTSIDE;
+    if (dist - extent < 0.0f)
+      result = INTERSECTING;
+  }
+  return result;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
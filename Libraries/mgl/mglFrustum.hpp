@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// View Frustum Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_FRUSTUM_HPP
+#define MGL_FRUSTUM_HPP
+
+#include <glm/glm.hpp>
+
+namespace mgl {
+
+class Frustum;
+
+//////////////////////////////////////////////////////////////////////// Frustum
+
+// The six clip planes of a view-projection matrix, normals pointing inwards.
+// Planes are kept as structure-of-arrays (padded to eight) so one sphere is
+// tested against all of them with two SSE operations per component.
+
+class Frustum final {
+public:
+  enum Result { OUTSIDE = 0, INTERSECTING = 1, INSIDE = 2 };
+
+  Frustum();
+  explicit Frustum(const glm::mat4 &view_projection);
+
+  void update(const glm::mat4 &view_projection);
+  Result testSphere(const glm::vec3 &center, const float radius) const;
+  Result testAabb(const glm::vec3 &min, const glm::vec3 &max) const;
+
+private:
+  static const int PLANES = 6;
+  alignas(16) float Nx[8];
+  alignas(16) float Ny[8];
+  alignas(16) float Nz[8];
+  alignas(16) float D[8];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_FRUSTUM_HPP */
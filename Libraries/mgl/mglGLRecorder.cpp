@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL Command Recorder
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglGLRecorder.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <type_traits>
+
+#include "./mglNullGL.hpp"
+
+namespace mgl {
+
+///////////////////////////////////////////////////////////////////// GLRecorder
+
+namespace {
+
+enum CommandId {
+#define MGL_COMMAND_ID(name) CMD_##name,
+  MGL_GL_ENTRY_POINTS(MGL_COMMAND_ID)
+#undef MGL_COMMAND_ID
+  COMMAND_COUNT
+};
+
+const char *CommandNames[] = {
+#define MGL_COMMAND_NAME(name) #name,
+    MGL_GL_ENTRY_POINTS(MGL_COMMAND_NAME)
+#undef MGL_COMMAND_NAME
+};
+
+} // namespace
+
+const size_t GLRecorder::MAX_COMMANDS;
+
+// One wrapper per entry point: records the call, then forwards it to the
+// entry point that was installed before.
+template <int Id, typename R, typename... Args>
+struct GLRecorder::Wrapper<Id, R(GLAPIENTRY *)(Args...)> {
+  static R(GLAPIENTRY *Next)(Args...);
+
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value, Argument>::type
+  argument(const T value) {
+    return Argument{Argument::INTEGER, static_cast<long long>(value), 0.0};
+  }
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value,
+                                 Argument>::type
+  argument(const T value) {
+    return Argument{Argument::REAL, 0, static_cast<double>(value)};
+  }
+  template <typename T>
+  static typename std::enable_if<std::is_pointer<T>::value, Argument>::type
+  argument(const T value) {
+    return Argument{Argument::POINTER, value ? 1 : 0, 0.0};
+  }
+
+  static R GLAPIENTRY call(Args... args) {
+    // the first element only keeps the array from being empty
+    const Argument arguments[] = {Argument{Argument::INTEGER, 0, 0.0},
+                                  argument(args)...};
+    getInstance().call(Id, arguments + 1, sizeof...(Args));
+    return Next(args...);
+  }
+};
+
+template <int Id, typename R, typename... Args>
+R(GLAPIENTRY *GLRecorder::Wrapper<Id, R(GLAPIENTRY *)(Args...)>::Next)(
+    Args...) = nullptr;
+
+GLRecorder::GLRecorder()
+    : Installed(false), Capturing(false), CurrentCalls(COMMAND_COUNT, 0),
+      FrameCalls(COMMAND_COUNT, 0), Frame(0) {}
+
+GLRecorder &GLRecorder::getInstance() {
+  static GLRecorder instance;
+  return instance;
+}
+
+void GLRecorder::install() {
+  if (Installed)
+    return;
+#define MGL_RECORD(name)                                                       \
+  Wrapper<CMD_##name, decltype(name)>::Next = name;                            \
+  name = Wrapper<CMD_##name, decltype(name)>::call;
+  MGL_GL_ENTRY_POINTS(MGL_RECORD)
+#undef MGL_RECORD
+  State = BoundState();
+  Installed = true;
+}
+
+void GLRecorder::uninstall() {
+  if (!Installed)
+    return;
+#define MGL_RESTORE(name) name = Wrapper<CMD_##name, decltype(name)>::Next;
+  MGL_GL_ENTRY_POINTS(MGL_RESTORE)
+#undef MGL_RESTORE
+  Installed = false;
+}
+
+void GLRecorder::call(const int id, const Argument *arguments,
+                      const size_t count) {
+  CurrentCounts.Calls++;
+  CurrentCalls[id]++;
+  track(id, arguments);
+  if (Capturing && Commands.size() < MAX_COMMANDS) {
+    Commands.push_back(Command{id, Arguments.size(), count});
+    Arguments.insert(Arguments.end(), arguments, arguments + count);
+  }
+}
+
+void GLRecorder::bind(GLuint &bound, const long long name) {
+  CurrentCounts.StateChanges++;
+  if (bound == GLuint(name))
+    CurrentCounts.RedundantBinds++;
+  bound = GLuint(name);
+}
+
+// Binding a buffer to an indexed target also binds it to the generic one.
+void GLRecorder::track(const int id, const Argument *arguments) {
+  Counts &counts = CurrentCounts;
+  switch (id) {
+  case CMD_glUseProgram:
+    bind(State.Program, arguments[0].Integer);
+    break;
+  case CMD_glBindProgramPipeline:
+    bind(State.Pipeline, arguments[0].Integer);
+    break;
+  case CMD_glBindVertexArray:
+    bind(State.VertexArray, arguments[0].Integer);
+    break;
+  case CMD_glBindBuffer:
+    bind(State.Buffers[GLenum(arguments[0].Integer)], arguments[1].Integer);
+    break;
+  case CMD_glBindBufferBase:
+  case CMD_glBindBufferRange:
+    bind(State.Buffers[GLenum(arguments[0].Integer)], arguments[2].Integer);
+    break;
+  case CMD_glBindFramebuffer: {
+    const GLenum target = GLenum(arguments[0].Integer);
+    const GLuint name = GLuint(arguments[1].Integer);
+    counts.StateChanges++;
+    const bool draw = target != GL_READ_FRAMEBUFFER;
+    const bool read = target != GL_DRAW_FRAMEBUFFER;
+    if ((!draw || State.DrawFramebuffer == name) &&
+        (!read || State.ReadFramebuffer == name))
+      counts.RedundantBinds++;
+    if (draw)
+      State.DrawFramebuffer = name;
+    if (read)
+      State.ReadFramebuffer = name;
+    break;
+  }
+  case CMD_glBindRenderbuffer:
+    bind(State.Renderbuffer, arguments[1].Integer);
+    break;
+  case CMD_glActiveTexture:
+    bind(State.ActiveTexture, arguments[0].Integer);
+    break;
+  case CMD_glBindImageTexture:
+  case CMD_glBindVertexBuffer:
+  case CMD_glUseProgramStages:
+    counts.StateChanges++;
+    break;
+  case CMD_glDrawElementsBaseVertex:
+  case CMD_glDrawElementsInstancedBaseVertexBaseInstance:
+  case CMD_glMultiDrawElementsIndirect:
+    counts.DrawCalls++;
+    break;
+  case CMD_glDispatchCompute:
+    counts.Dispatches++;
+    break;
+  case CMD_glProgramUniform1f:
+  case CMD_glProgramUniform1i:
+  case CMD_glProgramUniform2fv:
+  case CMD_glProgramUniform3fv:
+  case CMD_glProgramUniform4fv:
+  case CMD_glProgramUniformMatrix3fv:
+  case CMD_glProgramUniformMatrix4fv:
+    counts.UniformUploads++;
+    break;
+  case CMD_glBufferData:
+    counts.BufferBytes += static_cast<unsigned long long>(arguments[1].Integer);
+    break;
+  case CMD_glBufferSubData:
+    counts.BufferBytes += static_cast<unsigned long long>(arguments[2].Integer);
+    break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////// Frames
+
+void GLRecorder::endFrame() {
+  if (!Installed)
+    return;
+  FrameCounts = CurrentCounts;
+  CurrentCounts = Counts();
+  FrameCalls.swap(CurrentCalls);
+  std::fill(CurrentCalls.begin(), CurrentCalls.end(), 0);
+  if (Capturing && Commands.size() < MAX_COMMANDS)
+    Commands.push_back(Command{-1, size_t(Frame), 0});
+  Frame++;
+}
+
+unsigned long long GLRecorder::getFrameCalls(const std::string &name) const {
+  for (int i = 0; i < COMMAND_COUNT; i++) {
+    if (name == CommandNames[i])
+      return FrameCalls[i];
+  }
+  return 0;
+}
+
+// Entry points called in the last frame, most called first.
+void GLRecorder::printFrame(std::ostream &out) const {
+  const std::ios::fmtflags flags = out.flags();
+  out << "  draw calls " << FrameCounts.DrawCalls << ", dispatches "
+      << FrameCounts.Dispatches << ", state changes "
+      << FrameCounts.StateChanges << " (" << FrameCounts.RedundantBinds
+      << " redundant), uniform uploads " << FrameCounts.UniformUploads
+      << ", buffer bytes " << FrameCounts.BufferBytes << "\n";
+  std::vector<int> order;
+  for (int i = 0; i < COMMAND_COUNT; i++) {
+    if (FrameCalls[i])
+      order.push_back(i);
+  }
+  std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+    return FrameCalls[a] > FrameCalls[b];
+  });
+  for (int i : order)
+    out << "  " << std::left << std::setw(48) << CommandNames[i] << std::right
+        << std::setw(9) << FrameCalls[i] << "\n";
+  out.flags(flags);
+}
+
+////////////////////////////////////////////////////////////// Command stream
+
+void GLRecorder::startCapture() {
+  Commands.clear();
+  Arguments.clear();
+  Capturing = true;
+}
+
+void GLRecorder::stopCapture() { Capturing = false; }
+
+void GLRecorder::writeCommands(const std::string &filename) const {
+  std::ofstream file(filename);
+  if (!file)
+    throw std::runtime_error("Cannot write " + filename);
+  file << std::setprecision(9);
+  for (const Command &command : Commands) {
+    if (command.Id < 0) {
+      file << "frame " << command.First << "\n";
+      continue;
+    }
+    file << CommandNames[command.Id];
+    for (size_t i = 0; i < command.Count; i++) {
+      const Argument &argument = Arguments[command.First + i];
+      file << " ";
+      if (argument.Type == Argument::INTEGER)
+        file << argument.Integer;
+      else if (argument.Type == Argument::REAL)
+        file << argument.Real;
+      else
+        file << (argument.Integer ? "ptr" : "null");
+    }
+    file << "\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
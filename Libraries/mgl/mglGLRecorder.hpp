@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL Command Recorder
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_GL_RECORDER_HPP
+#define MGL_GL_RECORDER_HPP
+
+#include <GL/glew.h>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mgl {
+
+class GLRecorder;
+
+///////////////////////////////////////////////////////////////////// GLRecorder
+
+// Sits between the application and the entry points of MGL_GL_ENTRY_POINTS
+// (a real context or NullGL): every call is counted, the bound objects are
+// shadowed and, while capturing, the call and its arguments are kept so the
+// command stream can be written out and diffed or replayed. Over NullGL the
+// counts are deterministic, which makes them usable as CI checks. The Engine
+// closes each frame. OpenGL 1.1 functions (glDrawArrays, glBindTexture,
+// glEnable, ...) are not loaded by GLEW and cannot be recorded; StateCache
+// counts the state changes that go through it.
+
+class GLRecorder final {
+public:
+  static const size_t MAX_COMMANDS = 1 << 20;
+
+  struct Counts {
+    unsigned long long Calls = 0;
+    unsigned long long DrawCalls = 0;  // glDraw*, glMultiDraw*
+    unsigned long long Dispatches = 0; // glDispatchCompute
+    unsigned long long StateChanges = 0;
+    unsigned long long RedundantBinds = 0; // binds of what was already bound
+    unsigned long long UniformUploads = 0;
+    unsigned long long BufferBytes = 0; // glBufferData and glBufferSubData
+  };
+
+  struct BoundState {
+    GLuint Program = 0, Pipeline = 0, VertexArray = 0;
+    GLuint DrawFramebuffer = 0, ReadFramebuffer = 0, Renderbuffer = 0;
+    GLenum ActiveTexture = GL_TEXTURE0;
+    std::map<GLenum, GLuint> Buffers;
+  };
+
+  static GLRecorder &getInstance();
+
+  // Wraps the current entry points: call after glewInit() or NullGL::install()
+  // (either one replaces the wrappers).
+  void install();
+  void uninstall();
+  bool isInstalled() const { return Installed; }
+
+  void endFrame();
+  // Counters of the last completed frame.
+  const Counts &getFrameCounts() const { return FrameCounts; }
+  unsigned long long getFrameCalls(const std::string &name) const;
+  const BoundState &getBoundState() const { return State; }
+  void printFrame(std::ostream &out) const;
+
+  void startCapture();
+  void stopCapture();
+  bool isCapturing() const { return Capturing; }
+  // One call per line: the entry point and its arguments, pointers as
+  // "ptr" or "null"; "frame N" lines separate the frames.
+  void writeCommands(const std::string &filename) const;
+
+private:
+  struct Argument {
+    enum Kind { INTEGER, REAL, POINTER } Type;
+    long long Integer;
+    double Real;
+  };
+
+  struct Command {
+    int Id; // -1 marks the end of a frame
+    size_t First, Count;
+  };
+
+  template <int Id, typename F> struct Wrapper;
+
+  bool Installed, Capturing;
+  Counts CurrentCounts, FrameCounts;
+  std::vector<unsigned long long> CurrentCalls, FrameCalls;
+  BoundState State;
+  unsigned long long Frame;
+  std::vector<Command> Commands;
+  std::vector<Argument> Arguments;
+
+  GLRecorder();
+  ~GLRecorder() = default;
+  void call(const int id, const Argument *arguments, const size_t count);
+  void track(const int id, const Argument *arguments);
+  void bind(GLuint &bound, const long long name);
+
+public:
+  GLRecorder(GLRecorder const &) = delete;
+  void operator=(GLRecorder const &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_GL_RECORDER_HPP */
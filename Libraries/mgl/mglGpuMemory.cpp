@@ -0,0 +1,43 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// GPU Memory Accounting
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglGpuMemory.hpp"
+
+#include <algorithm>
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////////////// GpuMemory
+
+GpuMemory::GpuMemory() {
+  for (int i = 0; i < KIND_COUNT; i++)
+    Bytes[i] = 0;
+}
+
+GpuMemory &GpuMemory::getInstance() {
+  static GpuMemory instance;
+  return instance;
+}
+
+void GpuMemory::allocate(const Kind kind, const size_t bytes) {
+  Bytes[kind] += bytes;
+}
+
+void GpuMemory::release(const Kind kind, const size_t bytes) {
+  Bytes[kind] -= std::min(bytes, Bytes[kind]);
+}
+
+size_t GpuMemory::getTotalBytes() const {
+  size_t total = 0;
+  for (int i = 0; i < KIND_COUNT; i++)
+    total += Bytes[i];
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// GPU Memory Accounting
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_GPU_MEMORY_HPP
+#define MGL_GPU_MEMORY_HPP
+
+#include <cstddef>
+
+namespace mgl {
+
+class GpuMemory;
+
+////////////////////////////////////////////////////////////////////// GpuMemory
+
+// Bytes requested for the storage of GL objects, per kind, as reported by
+// the code that allocates them (Mesh, Framebuffer, OcclusionCuller, ...).
+// Drivers add padding and their own copies, so this is the application's
+// share, not the process's total.
+
+class GpuMemory final {
+public:
+  enum Kind { MESH_BUFFERS, TEXTURES, KIND_COUNT };
+
+  static GpuMemory &getInstance();
+
+  void allocate(const Kind kind, const size_t bytes);
+  void release(const Kind kind, const size_t bytes);
+  size_t getBytes(const Kind kind) const { return Bytes[kind]; }
+  size_t getTotalBytes() const;
+
+private:
+  size_t Bytes[KIND_COUNT];
+
+  GpuMemory();
+  ~GpuMemory() = default;
+
+public:
+  GpuMemory(GpuMemory const &) = delete;
+  void operator=(GpuMemory const &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_GPU_MEMORY_HPP */
@@ -8,8 +8,15 @@
 
 #include "./mglMesh.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
 
+#include "./mglGpuMemory.hpp"
+#include "./mglStateCache.hpp"
+
+
 namespace mgl {
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -19,6 +26,8 @@ Mesh::Mesh() {
   TexcoordsLoaded = false;
   TangentsAndBitangentsLoaded = false;
   VaoId = -1;
+  InstanceBufferId = 0;
+  BufferBytes = 0;
   AssimpFlags = aiProcess_Triangulate;
 }
 
@@ -44,6 +53,10 @@ void Mesh::calculateTangentSpace() {
 
 void Mesh::flipUVs() { AssimpFlags |= aiProcess_FlipUVs; }
 
+const Mesh::Bounds &Mesh::getBounds(int meshIndex) const {
+  return meshIndex >= 0 ? Meshes[meshIndex].bounds : MeshBounds;
+}
+
 bool Mesh::hasNormals() { return NormalsLoaded; }
 
 bool Mesh::hasTexcoords() { return TexcoordsLoaded; }
@@ -101,6 +114,24 @@ void Mesh::clear() {
   Meshes.clear();
 }
 
+static Mesh::Bounds computeBounds(const glm::vec3 *positions,
+                                  const size_t count) {
+  Mesh::Bounds bounds;
+  bounds.Min = bounds.Max = count ? positions[0] : glm::vec3(0.0f);
+  for (size_t i = 1; i < count; i++) {
+    bounds.Min = glm::min(bounds.Min, positions[i]);
+    bounds.Max = glm::max(bounds.Max, positions[i]);
+  }
+  bounds.Center = (bounds.Min + bounds.Max) * 0.5f;
+  float radius2 = 0.0f;
+  for (size_t i = 0; i < count; i++) {
+    const glm::vec3 d = positions[i] - bounds.Center;
+    radius2 = std::max(radius2, glm::dot(d, d));
+  }
+  bounds.Radius = std::sqrt(radius2);
+  return bounds;
+}
+
 void Mesh::processScene(const aiScene *scene) {
   Meshes.resize(scene->mNumMeshes);
   unsigned int n_vertices = 0;
@@ -110,6 +141,7 @@ void Mesh::processScene(const aiScene *scene) {
     Meshes[i].nIndices = scene->mMeshes[i]->mNumFaces * 3;
     Meshes[i].baseVertex = n_vertices;
     Meshes[i].baseIndex = n_indices;
+    Meshes[i].nVertices = scene->mMeshes[i]->mNumVertices;
     Meshes[i].name = scene->mMeshes[i]->mName.C_Str();
 
     n_vertices += scene->mMeshes[i]->mNumVertices;
@@ -123,6 +155,10 @@ void Mesh::processScene(const aiScene *scene) {
   for (unsigned int i = 0; i < Meshes.size(); i++) {
     processMesh(scene->mMeshes[i]);
   }
+  for (MeshData &mesh : Meshes) {
+    mesh.bounds = computeBounds(&Positions[mesh.baseVertex], mesh.nVertices);
+  }
+  MeshBounds = computeBounds(Positions.data(), Positions.size());
 
 #ifdef DEBUG
   std::cout << "Loaded " << Meshes.size() << " mesh(es) [" << n_vertices
@@ -150,63 +186,92 @@ void Mesh::create(const std::string &filename) {
   createBufferObjects();
 }
 
+void Mesh::create(const aiScene *scene) {
+  clear();
+  processScene(scene);
+  createBufferObjects();
+}
+
 void Mesh::createBufferObjects() {
   GLuint boId[6];
+  size_t bytes = 0;
+  StateCache &cache = StateCache::getInstance();
 
   glGenVertexArrays(1, &VaoId);
-  glBindVertexArray(VaoId);
+  cache.bindVertexArray(VaoId);
   {
     glGenBuffers(6, boId);
 
-    glBindBuffer(GL_ARRAY_BUFFER, boId[POSITION]);
+    cache.bindBuffer(GL_ARRAY_BUFFER, boId[POSITION]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(Positions[0]) * Positions.size(),
                  &Positions[0], GL_STATIC_DRAW);
+    bytes += sizeof(Positions[0]) * Positions.size();
     glEnableVertexAttribArray(POSITION);
     glVertexAttribPointer(POSITION, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
     if (NormalsLoaded) {
-      glBindBuffer(GL_ARRAY_BUFFER, boId[NORMAL]);
+      cache.bindBuffer(GL_ARRAY_BUFFER, boId[NORMAL]);
       glBufferData(GL_ARRAY_BUFFER, sizeof(Normals[0]) * Normals.size(),
                    &Normals[0], GL_STATIC_DRAW);
+      bytes += sizeof(Normals[0]) * Normals.size();
       glEnableVertexAttribArray(NORMAL);
       glVertexAttribPointer(NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
     }
 
     if (TexcoordsLoaded) {
-      glBindBuffer(GL_ARRAY_BUFFER, boId[TEXCOORD]);
+      cache.bindBuffer(GL_ARRAY_BUFFER, boId[TEXCOORD]);
       glBufferData(GL_ARRAY_BUFFER, sizeof(Texcoords[0]) * Texcoords.size(),
                    &Texcoords[0], GL_STATIC_DRAW);
+      bytes += sizeof(Texcoords[0]) * Texcoords.size();
       glEnableVertexAttribArray(TEXCOORD);
       glVertexAttribPointer(TEXCOORD, 2, GL_FLOAT, GL_FALSE, 0, 0);
     }
 
     if (TangentsAndBitangentsLoaded) {
-      glBindBuffer(GL_ARRAY_BUFFER, boId[TANGENT]);
+      cache.bindBuffer(GL_ARRAY_BUFFER, boId[TANGENT]);
       glBufferData(GL_ARRAY_BUFFER, sizeof(Tangents[0]) * Tangents.size(),
                    &Tangents[0], GL_STATIC_DRAW);
+      bytes += sizeof(Tangents[0]) * Tangents.size();
       glEnableVertexAttribArray(TANGENT);
       glVertexAttribPointer(TANGENT, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
 #ifdef CREATE_BITANGENT
-      glBindBuffer(GL_ARRAY_BUFFER, boId[BITANGENT]);
+      cache.bindBuffer(GL_ARRAY_BUFFER, boId[BITANGENT]);
       glBufferData(GL_ARRAY_BUFFER, sizeof(Bitangents[0]) * Bitangents.size(),
                    &Bitangents[0], GL_STATIC_DRAW);
+      bytes += sizeof(Bitangents[0]) * Bitangents.size();
       glEnableVertexAttribArray(BITANGENT);
       glVertexAttribPointer(BITANGENT, 3, GL_FLOAT, GL_FALSE, 0, 0);
 #endif
     }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, boId[INDEX]);
+    cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, boId[INDEX]);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Indices[0]) * Indices.size(),
                  &Indices[0], GL_STATIC_DRAW);
+    bytes += sizeof(Indices[0]) * Indices.size();
+
+    // Instance attributes share one binding, enabled by setInstanceBuffer().
+    for (GLuint i = 0; i < 4; i++) {
+      glVertexAttribFormat(INSTANCE_MATRIX + i, 4, GL_FLOAT, GL_FALSE,
+                           sizeof(glm::vec4) * i);
+      glVertexAttribBinding(INSTANCE_MATRIX + i, INSTANCE_MATRIX);
+    }
+    glVertexAttribFormat(INSTANCE_MATERIAL, 4, GL_FLOAT, GL_FALSE,
+                         offsetof(InstanceData, Material));
+    glVertexAttribBinding(INSTANCE_MATERIAL, INSTANCE_MATRIX);
+    glVertexBindingDivisor(INSTANCE_MATRIX, 1);
   }
-  glBindVertexArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  cache.bindVertexArray(0);
+  cache.bindBuffer(GL_ARRAY_BUFFER, 0);
   glDeleteBuffers(6, boId);
+  // The deleted names stay alive while the VAO references them.
+  BufferBytes += bytes;
+  GpuMemory::getInstance().allocate(GpuMemory::MESH_BUFFERS, bytes);
 }
 
 void Mesh::destroyBufferObjects() {
-  glBindVertexArray(VaoId);
+  StateCache &cache = StateCache::getInstance();
+  cache.bindVertexArray(VaoId);
   glDisableVertexAttribArray(POSITION);
   glDisableVertexAttribArray(NORMAL);
   glDisableVertexAttribArray(TEXCOORD);
@@ -214,16 +279,33 @@ void Mesh::destroyBufferObjects() {
 #ifdef CREATE_BITANGENT
   glDisableVertexAttribArray(BITANGENT);
 #endif
+  for (GLuint i = INSTANCE_MATRIX; i <= INSTANCE_MATERIAL; i++)
+    glDisableVertexAttribArray(i);
+  cache.bindVertexArray(0);
   glDeleteVertexArrays(1, &VaoId);
-  glBindVertexArray(0);
+  GpuMemory::getInstance().release(GpuMemory::MESH_BUFFERS, BufferBytes);
+  BufferBytes = 0;
 }
 
 void Mesh::draw() {
     draw(-1); // draw all submeshes
 }
 
+void Mesh::setInstanceBuffer(const GLuint buffer) {
+  if (buffer == InstanceBufferId)
+    return;
+  StateCache::getInstance().bindVertexArray(VaoId);
+  if (InstanceBufferId == 0) {
+    for (GLuint i = INSTANCE_MATRIX; i <= INSTANCE_MATERIAL; i++)
+      glEnableVertexAttribArray(i);
+  }
+  glBindVertexBuffer(INSTANCE_MATRIX, buffer, 0, sizeof(InstanceData));
+  InstanceBufferId = buffer;
+}
+
+// The VAO stays bound: the next draw rebinds only if it uses another one.
 void Mesh::draw(int meshIndex) {
-    glBindVertexArray(VaoId);
+    StateCache::getInstance().bindVertexArray(VaoId);
     if (meshIndex >= 0) {
         MeshData& mesh = Meshes[meshIndex];
         glDrawElementsBaseVertex(GL_TRIANGLES, mesh.nIndices, GL_UNSIGNED_INT,
@@ -237,9 +319,94 @@ void Mesh::draw(int meshIndex) {
                 mesh.baseVertex);
         }
     }
-    glBindVertexArray(0);
 }
 
+void Mesh::drawInstanced(int meshIndex, const GLsizei instances,
+                         const GLuint base_instance) {
+  StateCache::getInstance().bindVertexArray(VaoId);
+  for (size_t i = 0; i < Meshes.size(); i++) {
+    if (meshIndex >= 0 && size_t(meshIndex) != i)
+      continue;
+    const MeshData &mesh = Meshes[i];
+    glDrawElementsInstancedBaseVertexBaseInstance(
+        GL_TRIANGLES, mesh.nIndices, GL_UNSIGNED_INT,
+        reinterpret_cast<void *>(sizeof(unsigned int) * mesh.baseIndex),
+        instances, mesh.baseVertex, base_instance);
+  }
+}
+
+void Mesh::appendDrawCommands(std::vector<DrawCommand> &commands,
+                              int meshIndex, const GLuint instances,
+                              const GLuint base_instance) const {
+  for (size_t i = 0; i < Meshes.size(); i++) {
+    if (meshIndex >= 0 && size_t(meshIndex) != i)
+      continue;
+    const MeshData &mesh = Meshes[i];
+    DrawCommand command = {mesh.nIndices, instances, mesh.baseIndex,
+                           GLint(mesh.baseVertex), base_instance};
+    commands.push_back(command);
+  }
+}
+
+void Mesh::drawIndirect(const GLintptr offset, const GLsizei count) {
+  StateCache::getInstance().bindVertexArray(VaoId);
+  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                              reinterpret_cast<const void *>(offset), count,
+                              0);
+}
+
+// Moller-Trumbore; returns a negative distance on a miss.
+float Mesh::intersectTriangle(const MeshData &mesh, const unsigned int triangle,
+                              const Bvh::Ray &ray) const {
+  const unsigned int *index = &Indices[mesh.baseIndex + 3 * triangle];
+  const glm::vec3 &v0 = Positions[mesh.baseVertex + index[0]];
+  const glm::vec3 e1 = Positions[mesh.baseVertex + index[1]] - v0;
+  const glm::vec3 e2 = Positions[mesh.baseVertex + index[2]] - v0;
+  const glm::vec3 p = glm::cross(ray.Direction, e2);
+  const float det = glm::dot(e1, p);
+  if (std::fabs(det) < 1e-12f)
+    return -1.0f;
+  const float inv_det = 1.0f / det;
+  const glm::vec3 s = ray.Origin - v0;
+  const float u = glm::dot(s, p) * inv_det;
+  if (u < 0.0f || u > 1.0f)
+    return -1.0f;
+  const glm::vec3 q = glm::cross(s, e1);
+  const float v = glm::dot(ray.Direction, q) * inv_det;
+  if (v < 0.0f || u + v > 1.0f)
+    return -1.0f;
+  return glm::dot(e2, q) * inv_det;
+}
+
+bool Mesh::intersect(const Bvh::Ray &ray, float &distance, int meshIndex) {
+  bool hit = false;
+  for (size_t i = 0; i < Meshes.size(); i++) {
+    if (meshIndex >= 0 && size_t(meshIndex) != i)
+      continue;
+    MeshData &mesh = Meshes[i];
+    if (mesh.triangles.empty() && mesh.nIndices > 0) {
+      std::vector<Bvh::Aabb> bounds(mesh.nIndices / 3);
+      for (unsigned int t = 0; t < bounds.size(); t++) {
+        const unsigned int *index = &Indices[mesh.baseIndex + 3 * t];
+        const glm::vec3 &v0 = Positions[mesh.baseVertex + index[0]];
+        const glm::vec3 &v1 = Positions[mesh.baseVertex + index[1]];
+        const glm::vec3 &v2 = Positions[mesh.baseVertex + index[2]];
+        bounds[t].Min = glm::min(v0, glm::min(v1, v2));
+        bounds[t].Max = glm::max(v0, glm::max(v1, v2));
+      }
+      mesh.triangles.build(bounds);
+    }
+    const MeshData &data = mesh;
+    hit |= mesh.triangles.raycast(
+               ray,
+               [this, &data](unsigned int triangle, const Bvh::Ray &r,
+                             float) {
+                 return intersectTriangle(data, triangle, r);
+               },
+               distance) >= 0;
+  }
+  return hit;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 } // namespace mgl
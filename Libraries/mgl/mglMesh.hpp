@@ -17,6 +17,7 @@
 #include <string>
 #include <vector>
 
+#include "./mglBvh.hpp"
 #include "./mglScenegraph.hpp"
 
 namespace mgl {
@@ -27,7 +28,7 @@ class Mesh;
 
 /////////////////////////////////////////////////////////////////////////// Mesh
 
-class Mesh : public IDrawable {
+class Mesh final : public IDrawable {
 public:
   static const GLuint INDEX = 0;
   static const GLuint POSITION = 1;
@@ -37,6 +38,30 @@ public:
 #ifdef CREATE_BITANGENT
   static const GLuint BITANGENT = 5;
 #endif
+  // Per-instance attributes: a mat4 (4 locations) followed by a vec4.
+  static const GLuint INSTANCE_MATRIX = 6;
+  static const GLuint INSTANCE_MATERIAL = 10;
+
+  struct InstanceData {
+    glm::mat4 ModelMatrix;
+    glm::vec4 Material;
+  };
+
+  // Model space bounds: an AABB and a sphere around the AABB center.
+  struct Bounds {
+    glm::vec3 Min, Max;
+    glm::vec3 Center;
+    float Radius;
+  };
+
+  // Layout of glMultiDrawElementsIndirect commands.
+  struct DrawCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+  };
 
   Mesh();
   ~Mesh();
@@ -56,9 +81,26 @@ public:
   void flipUVs();
 
   void create(const std::string &filename);
+  // From a scene built in memory (e.g. procedural or synthetic meshes).
+  void create(const aiScene *scene);
   void draw() override;
   void draw(int meshIndex); // overload
+  void setInstanceBuffer(const GLuint buffer);
+  void drawInstanced(int meshIndex, const GLsizei instances,
+                     const GLuint base_instance = 0);
+  // One command per submesh (all of them if meshIndex is -1).
+  void appendDrawCommands(std::vector<DrawCommand> &commands, int meshIndex,
+                          const GLuint instances,
+                          const GLuint base_instance) const;
+  // Commands are read from the bound GL_DRAW_INDIRECT_BUFFER.
+  void drawIndirect(const GLintptr offset, const GLsizei count);
   size_t getMeshCount() const { return Meshes.size(); } // getter for Meshes
+  const Bounds &getBounds(int meshIndex = -1) const; // -1 for the whole mesh
+  // Closest triangle hit in model space, closer than distance (updated on a
+  // hit). Triangle BVHs are built on the first query of each submesh.
+  bool intersect(const Bvh::Ray &ray, float &distance, int meshIndex = -1);
+  // Bytes uploaded to the vertex and index buffers.
+  size_t getBufferBytes() const { return BufferBytes; }
 
   bool hasNormals();
   bool hasTexcoords();
@@ -66,6 +108,8 @@ public:
 
 private:
   GLuint VaoId;
+  GLuint InstanceBufferId;
+  size_t BufferBytes;
   unsigned int AssimpFlags;
   bool NormalsLoaded, TexcoordsLoaded, TangentsAndBitangentsLoaded;
 
@@ -73,9 +117,13 @@ private:
     unsigned int nIndices = 0;
     unsigned int baseIndex = 0;
     unsigned int baseVertex = 0;
+    unsigned int nVertices = 0;
     std::string name;
+    Bounds bounds;
+    Bvh triangles;
   };
   std::vector<MeshData> Meshes;
+  Bounds MeshBounds;
 
   std::vector<glm::vec3> Positions;
   std::vector<glm::vec3> Normals;
@@ -91,6 +139,8 @@ private:
   void processMesh(const aiMesh *mesh);
   void createBufferObjects();
   void destroyBufferObjects();
+  float intersectTriangle(const MeshData &mesh, const unsigned int triangle,
+                          const Bvh::Ray &ray) const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
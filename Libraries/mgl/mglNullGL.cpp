@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Null OpenGL Backend
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglNullGL.hpp"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace mgl {
+
+///////////////////////////////////////////////////////////////////////// NullGL
+
+namespace {
+
+// One stub per signature: ignores the arguments and returns zero.
+template <typename F> struct NullStub;
+template <typename R, typename... Args>
+struct NullStub<R(GLAPIENTRY *)(Args...)> {
+  static R GLAPIENTRY call(Args...) { return R(); }
+};
+
+GLuint NextName = 1;
+
+void GLAPIENTRY genNames(GLsizei n, GLuint *names) {
+  for (GLsizei i = 0; i < n; i++)
+    names[i] = NextName++;
+}
+
+GLuint GLAPIENTRY createObject() { return NextName++; }
+GLuint GLAPIENTRY createShader(GLenum) { return NextName++; }
+
+// Status queries succeed; every other value is 0.
+void GLAPIENTRY getStatus(GLuint, GLenum pname, GLint *param) {
+  *param = (pname == GL_COMPILE_STATUS || pname == GL_LINK_STATUS ||
+            pname == GL_VALIDATE_STATUS)
+               ? GL_TRUE
+               : 0;
+}
+
+void GLAPIENTRY getInterface(GLuint, GLenum, GLenum, GLint *param) {
+  *param = 0;
+}
+
+void GLAPIENTRY getResource(GLuint, GLenum, GLuint, GLsizei, const GLenum *,
+                            GLsizei count, GLsizei *length, GLint *params) {
+  for (GLsizei i = 0; i < count; i++)
+    params[i] = 0;
+  if (length)
+    *length = count;
+}
+
+void GLAPIENTRY getQueryuiv(GLuint, GLenum pname, GLuint *param) {
+  *param = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+void GLAPIENTRY getQueryui64v(GLuint, GLenum, GLuint64 *param) { *param = 0; }
+
+void GLAPIENTRY getBufferSubData(GLenum, GLintptr, GLsizeiptr size,
+                                 void *data) {
+  std::memset(data, 0, size_t(size));
+}
+
+GLint GLAPIENTRY getUniformLocation(GLuint, const GLchar *) { return -1; }
+
+GLuint GLAPIENTRY getUniformBlockIndex(GLuint, const GLchar *) {
+  return GL_INVALID_INDEX;
+}
+
+GLenum GLAPIENTRY checkFramebuffer(GLenum) { return GL_FRAMEBUFFER_COMPLETE; }
+
+// Every mapping gets its own memory, kept until exit: persistent mappings
+// stay valid and writes go nowhere, like every other call.
+std::vector<std::unique_ptr<unsigned char[]>> Mappings;
+
+void *GLAPIENTRY mapBufferRange(GLenum, GLintptr, GLsizeiptr length,
+                                GLbitfield) {
+  Mappings.emplace_back(new unsigned char[size_t(length)]);
+  return Mappings.back().get();
+}
+
+GLenum GLAPIENTRY clientWaitSync(GLsync, GLbitfield, GLuint64) {
+  return GL_ALREADY_SIGNALED;
+}
+
+} // namespace
+
+void NullGL::install() {
+#define MGL_NULL_STUB(name) name = NullStub<decltype(name)>::call;
+  MGL_GL_ENTRY_POINTS(MGL_NULL_STUB)
+#undef MGL_NULL_STUB
+
+  glGenBuffers = genNames;
+  glGenFramebuffers = genNames;
+  glGenProgramPipelines = genNames;
+  glGenQueries = genNames;
+  glGenRenderbuffers = genNames;
+  glGenVertexArrays = genNames;
+  glCreateProgram = createObject;
+  glCreateShader = createShader;
+  glGetShaderiv = getStatus;
+  glGetProgramiv = getStatus;
+  glGetProgramPipelineiv = getStatus;
+  glGetProgramInterfaceiv = getInterface;
+  glGetProgramResourceiv = getResource;
+  glGetQueryObjectuiv = getQueryuiv;
+  glGetQueryObjectui64v = getQueryui64v;
+  glGetBufferSubData = getBufferSubData;
+  glGetUniformLocation = getUniformLocation;
+  glGetUniformBlockIndex = getUniformBlockIndex;
+  glCheckFramebufferStatus = checkFramebuffer;
+  glMapBufferRange = mapBufferRange;
+  glClientWaitSync = clientWaitSync;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
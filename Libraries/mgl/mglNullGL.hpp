@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Null OpenGL Backend
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_NULL_GL_HPP
+#define MGL_NULL_GL_HPP
+
+#include <GL/glew.h>
+
+namespace mgl {
+
+class NullGL;
+
+// GLEW-loaded entry points used by mgl and its apps, for backends that
+// replace them: X(name) is called once per entry point.
+#define MGL_GL_ENTRY_POINTS(X)                                                 \
+  X(glActiveTexture)                                                           \
+  X(glAttachShader)                                                            \
+  X(glBeginQuery)                                                              \
+  X(glBindAttribLocation)                                                      \
+  X(glBindBuffer)                                                              \
+  X(glBindBufferBase)                                                          \
+  X(glBindBufferRange)                                                         \
+  X(glBindFramebuffer)                                                         \
+  X(glBindImageTexture)                                                        \
+  X(glBindProgramPipeline)                                                     \
+  X(glBindRenderbuffer)                                                        \
+  X(glBindVertexArray)                                                         \
+  X(glBindVertexBuffer)                                                        \
+  X(glBlitFramebuffer)                                                         \
+  X(glBufferData)                                                              \
+  X(glBufferStorage)                                                           \
+  X(glBufferSubData)                                                           \
+  X(glCheckFramebufferStatus)                                                  \
+  X(glClientWaitSync)                                                          \
+  X(glCompileShader)                                                           \
+  X(glCreateProgram)                                                           \
+  X(glCreateShader)                                                            \
+  X(glDebugMessageCallback)                                                    \
+  X(glDebugMessageControl)                                                     \
+  X(glDeleteBuffers)                                                           \
+  X(glDeleteFramebuffers)                                                      \
+  X(glDeleteProgram)                                                           \
+  X(glDeleteProgramPipelines)                                                  \
+  X(glDeleteQueries)                                                           \
+  X(glDeleteRenderbuffers)                                                     \
+  X(glDeleteShader)                                                            \
+  X(glDeleteSync)                                                              \
+  X(glDeleteVertexArrays)                                                      \
+  X(glDetachShader)                                                            \
+  X(glDisableVertexAttribArray)                                                \
+  X(glDispatchCompute)                                                         \
+  X(glDrawElementsBaseVertex)                                                  \
+  X(glDrawElementsInstancedBaseVertexBaseInstance)                             \
+  X(glEnableVertexAttribArray)                                                 \
+  X(glEndQuery)                                                                \
+  X(glFenceSync)                                                               \
+  X(glFramebufferRenderbuffer)                                                 \
+  X(glFramebufferTexture2D)                                                    \
+  X(glGenBuffers)                                                              \
+  X(glGenFramebuffers)                                                         \
+  X(glGenProgramPipelines)                                                     \
+  X(glGenQueries)                                                              \
+  X(glGenRenderbuffers)                                                        \
+  X(glGenVertexArrays)                                                         \
+  X(glGetBufferSubData)                                                        \
+  X(glGetProgramBinary)                                                        \
+  X(glGetProgramInfoLog)                                                       \
+  X(glGetProgramInterfaceiv)                                                   \
+  X(glGetProgramPipelineInfoLog)                                               \
+  X(glGetProgramPipelineiv)                                                    \
+  X(glGetProgramResourceIndex)                                                 \
+  X(glGetProgramResourceName)                                                  \
+  X(glGetProgramResourceiv)                                                    \
+  X(glGetProgramiv)                                                            \
+  X(glGetQueryObjectui64v)                                                     \
+  X(glGetQueryObjectuiv)                                                       \
+  X(glGetShaderInfoLog)                                                        \
+  X(glGetShaderiv)                                                             \
+  X(glGetUniformBlockIndex)                                                    \
+  X(glGetUniformLocation)                                                      \
+  X(glLinkProgram)                                                             \
+  X(glMapBufferRange)                                                          \
+  X(glMemoryBarrier)                                                           \
+  X(glMultiDrawElementsIndirect)                                               \
+  X(glProgramBinary)                                                           \
+  X(glProgramParameteri)                                                       \
+  X(glProgramUniform1f)                                                        \
+  X(glProgramUniform1i)                                                        \
+  X(glProgramUniform2fv)                                                       \
+  X(glProgramUniform3fv)                                                       \
+  X(glProgramUniform4fv)                                                       \
+  X(glProgramUniformMatrix3fv)                                                 \
+  X(glProgramUniformMatrix4fv)                                                 \
+  X(glQueryCounter)                                                            \
+  X(glRenderbufferStorage)                                                     \
+  X(glShaderSource)                                                            \
+  X(glTexStorage2D)                                                            \
+  X(glUniformBlockBinding)                                                     \
+  X(glUnmapBuffer)                                                             \
+  X(glUseProgram)                                                              \
+  X(glUseProgramStages)                                                        \
+  X(glValidateProgramPipeline)                                                 \
+  X(glVertexAttribBinding)                                                     \
+  X(glVertexAttribFormat)                                                      \
+  X(glVertexAttribPointer)                                                     \
+  X(glVertexBindingDivisor)
+
+///////////////////////////////////////////////////////////////////////// NullGL
+
+// Runs GL code without a GPU or a context, to measure the CPU side of
+// rendering (scene traversal, uniform uploads, mesh setup). install() points
+// the entry points above at stubs that do nothing: object names come from a
+// counter, compile/link/validate/framebuffer checks succeed, queries return
+// 0 and introspection finds no resources. OpenGL 1.1 functions (glEnable,
+// glBindTexture, glDrawArrays, ...) are exported by the system library, not
+// loaded by GLEW; without a current context they are no-ops.
+
+class NullGL final {
+public:
+  // Call instead of Engine::init(); real GL needs a new glewInit().
+  static void install();
+
+  NullGL() = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_NULL_GL_HPP */
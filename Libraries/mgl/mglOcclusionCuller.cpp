@@ -0,0 +1,282 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Hierarchical Depth Occlusion Culler Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglOcclusionCuller.hpp"
+
+#include <algorithm>
+
+#include "./mglGpuMemory.hpp"
+#include "./mglStateCache.hpp"
+
+namespace mgl {
+
+/////////////////////////////////////////////////////////////// OcclusionCuller
+
+const GLuint OcclusionCuller::REDUCE_GROUP_SIZE;
+const GLuint OcclusionCuller::CULL_GROUP_SIZE;
+const GLuint OcclusionCuller::BOXES_BINDING;
+const GLuint OcclusionCuller::PREVIOUS_BINDING;
+const GLuint OcclusionCuller::VISIBILITY_BINDING;
+const GLuint OcclusionCuller::COMMANDS_BINDING;
+const GLuint OcclusionCuller::TEXTURE_UNIT;
+const GLuint OcclusionCuller::IMAGE_UNIT;
+const int OcclusionCuller::LATENCY;
+
+OcclusionCuller::OcclusionCuller()
+    : SourceLevelSlot(-1), ViewProjectionSlot(-1), BoxCountSlot(-1),
+      PhaseSlot(-1), HasPreviousSlot(-1), DepthTexture(0), Pyramid(0),
+      BoxBuffer(0), Width(0), Height(0), Levels(0), TextureBytes(0),
+      Current(0), Previous(0), HasPrevious(false), Available(false), Count(0),
+      Capacity(0) {
+  for (int i = 0; i < LATENCY; i++) {
+    Slots[i] = 0;
+    Fences[i] = 0;
+    Pending[i] = false;
+  }
+}
+
+OcclusionCuller::~OcclusionCuller() {
+  destroyTextures();
+  for (int i = 0; i < LATENCY; i++)
+    if (Fences[i])
+      glDeleteSync(Fences[i]);
+  if (BoxBuffer)
+    glDeleteBuffers(1, &BoxBuffer);
+  if (Slots[0])
+    glDeleteBuffers(LATENCY, Slots);
+}
+
+void OcclusionCuller::create(const std::string &reduce_shader,
+                             const std::string &cull_shader) {
+  Reduce.addShader(GL_COMPUTE_SHADER, reduce_shader);
+  Reduce.enableIntrospection();
+  Reduce.create();
+  SourceLevelSlot = Reduce.getUniformSlot("sourceLevel");
+
+  Cull.addShader(GL_COMPUTE_SHADER, cull_shader);
+  Cull.enableIntrospection();
+  Cull.create();
+  ViewProjectionSlot = Cull.getUniformSlot("viewProjection");
+  BoxCountSlot = Cull.getUniformSlot("boxCount");
+  PhaseSlot = Cull.getUniformSlot("phase");
+  HasPreviousSlot = Cull.getUniformSlot("hasPrevious");
+
+  glGenBuffers(1, &BoxBuffer);
+  glGenBuffers(LATENCY, Slots);
+}
+
+void OcclusionCuller::destroyTextures() {
+  StateCache &cache = StateCache::getInstance();
+  if (DepthTexture) {
+    cache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &DepthTexture);
+    DepthTexture = 0;
+  }
+  if (Pyramid) {
+    cache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &Pyramid);
+    Pyramid = 0;
+  }
+  GpuMemory::getInstance().release(GpuMemory::TEXTURES, TextureBytes);
+  TextureBytes = 0;
+}
+
+void OcclusionCuller::resize(const GLsizei width, const GLsizei height) {
+  if (width == Width && height == Height && Pyramid)
+    return;
+  destroyTextures();
+  Width = width;
+  Height = height;
+  Levels = 0;
+  if (width <= 0 || height <= 0)
+    return;
+  for (GLsizei size = std::max(width, height); size > 0; size >>= 1)
+    Levels++;
+
+  StateCache &cache = StateCache::getInstance();
+  glGenTextures(1, &DepthTexture);
+  cache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, DepthTexture);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  glGenTextures(1, &Pyramid);
+  cache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, Pyramid);
+  glTexStorage2D(GL_TEXTURE_2D, Levels, GL_R32F, width, height);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  // 4 bytes per texel in the depth copy and in every pyramid level
+  TextureBytes = size_t(width) * height * 4;
+  for (int level = 0; level < Levels; level++)
+    TextureBytes += size_t(std::max(width >> level, 1)) *
+                    std::max(height >> level, 1) * 4;
+  GpuMemory::getInstance().allocate(GpuMemory::TEXTURES, TextureBytes);
+}
+
+// Level 0 is a copy of the depth buffer; each further level is reduced from
+// the previous one by a separate dispatch.
+void OcclusionCuller::buildPyramid() {
+  if (!Pyramid)
+    return;
+  StateCache &cache = StateCache::getInstance();
+  cache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, DepthTexture);
+  glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, Width, Height);
+
+  Reduce.bind();
+  GLsizei width = Width, height = Height;
+  for (int level = 0; level < Levels; level++) {
+    if (level == 1)
+      cache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, Pyramid);
+    if (level > 0) {
+      width = std::max(width / 2, 1);
+      height = std::max(height / 2, 1);
+    }
+    Reduce.setUniform(SourceLevelSlot, std::max(level - 1, 0));
+    glBindImageTexture(IMAGE_UNIT, Pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY,
+                       GL_R32F);
+    glDispatchCompute((width + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE,
+                      (height + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  }
+}
+
+// The generic binding changes with the indexed one: keep the cache in step.
+void OcclusionCuller::bindStorage(const GLuint binding, const GLuint buffer) {
+  StateCache::getInstance().bindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+}
+
+// Pending results belong to the old boxes and are dropped.
+void OcclusionCuller::resetHistory(const size_t count) {
+  for (int i = 0; i < LATENCY; i++) {
+    if (Fences[i])
+      glDeleteSync(Fences[i]);
+    Fences[i] = 0;
+    Pending[i] = false;
+  }
+  HasPrevious = false;
+  Available = false;
+  Count = count;
+  if (Count <= Capacity)
+    return;
+  Capacity = Count;
+  for (int i = 0; i < LATENCY; i++) {
+    bindStorage(VISIBILITY_BINDING, Slots[i]);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (Capacity + 1) * sizeof(GLuint),
+                 nullptr, GL_STREAM_READ);
+  }
+}
+
+void OcclusionCuller::setBoxes(const std::vector<Box> &boxes,
+                               const bool reset) {
+  if (reset || boxes.size() != Count)
+    resetHistory(boxes.size());
+  if (boxes.empty())
+    return;
+  bindStorage(BOXES_BINDING, BoxBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, boxes.size() * sizeof(Box),
+               boxes.data(), GL_STREAM_DRAW);
+}
+
+void OcclusionCuller::dispatch(const int phase, const GLuint command_buffer) {
+  bindStorage(BOXES_BINDING, BoxBuffer);
+  // without history the previous slot is not read
+  bindStorage(PREVIOUS_BINDING, Slots[HasPrevious ? Previous : Current]);
+  bindStorage(VISIBILITY_BINDING, Slots[Current]);
+  if (command_buffer)
+    bindStorage(COMMANDS_BINDING, command_buffer);
+
+  Cull.bind();
+  Cull.setUniform(BoxCountSlot, GLint(Count));
+  Cull.setUniform(PhaseSlot, phase);
+  Cull.setUniform(HasPreviousSlot, HasPrevious ? 1 : 0);
+  glDispatchCompute(GLuint((Count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE), 1,
+                    1);
+}
+
+void OcclusionCuller::selectPrevious(const GLuint command_buffer) {
+  if (Count == 0)
+    return;
+  dispatch(0, command_buffer);
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+// Only blocks if the GPU is more than LATENCY frames behind.
+void OcclusionCuller::selectVisible(const GLuint command_buffer,
+                                    const glm::mat4 &view_projection) {
+  if (Count == 0 || !Pyramid)
+    return;
+  if (Pending[Current])
+    collect(true);
+  // the slot is free (collected above): its hidden counter restarts at 0
+  const GLuint zero = 0;
+  bindStorage(VISIBILITY_BINDING, Slots[Current]);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+  Cull.bind();
+  Cull.setUniform(ViewProjectionSlot, view_projection);
+  StateCache::getInstance().bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, Pyramid);
+  dispatch(1, command_buffer);
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT |
+                  GL_BUFFER_UPDATE_BARRIER_BIT);
+
+  Fences[Current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  Pending[Current] = true;
+  Previous = Current;
+  Current = (Current + 1) % LATENCY;
+  HasPrevious = true;
+}
+
+// Fences signal in order, so the ring is read from the oldest slot (the next
+// to be written) and stops at the first one that is not ready yet.
+void OcclusionCuller::collect(const bool wait_for_oldest) {
+  for (int i = 0; i < LATENCY; i++) {
+    const int index = (Current + i) % LATENCY;
+    if (!Pending[index])
+      continue;
+    const GLuint64 timeout = i == 0 && wait_for_oldest ? 1000000 : 0;
+    GLenum status;
+    do {
+      status = glClientWaitSync(Fences[index], GL_SYNC_FLUSH_COMMANDS_BIT,
+                                timeout);
+    } while (status == GL_TIMEOUT_EXPIRED && timeout > 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+      break;
+    glDeleteSync(Fences[index]);
+    Fences[index] = 0;
+    Pending[index] = false;
+
+    Readback.resize(Count + 1);
+    StateCache::getInstance().bindBuffer(GL_SHADER_STORAGE_BUFFER,
+                                         Slots[index]);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+                       (Count + 1) * sizeof(GLuint), Readback.data());
+    Available = true;
+  }
+}
+
+bool OcclusionCuller::getVisibility(std::vector<unsigned char> &visible) {
+  collect(false);
+  if (!Available)
+    return false;
+  visible.resize(Count);
+  for (size_t i = 0; i < Count; i++)
+    visible[i] = Readback[i + 1] ? 1 : 0;
+  return true;
+}
+
+unsigned int OcclusionCuller::getHidden() {
+  collect(false);
+  return Available ? Readback[0] : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
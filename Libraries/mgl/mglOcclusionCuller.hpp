@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Hierarchical Depth Occlusion Culler Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_OCCLUSION_CULLER_HPP
+#define MGL_OCCLUSION_CULLER_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "./mglBvh.hpp"
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+class OcclusionCuller;
+
+/////////////////////////////////////////////////////////////// OcclusionCuller
+
+// Builds a max-depth pyramid (Hi-Z) from the depth buffer of the read
+// framebuffer and tests world space boxes against it in a compute shader.
+// Intended for two-phase culling without CPU round trips: the cull shader
+// writes the instanceCount of each box's indirect draw commands, first for
+// the boxes visible at the last test and then, once the pyramid is built
+// from that depth, for the boxes that became visible. The visibility history
+// stays on the GPU; the CPU gets it through a ring of buffers read a few
+// frames late, so that reading it never stalls (like Query).
+
+class OcclusionCuller final {
+public:
+  // Must match the compute shaders.
+  static const GLuint REDUCE_GROUP_SIZE = 8;
+  static const GLuint CULL_GROUP_SIZE = 64;
+  static const GLuint BOXES_BINDING = 0;
+  static const GLuint PREVIOUS_BINDING = 1;
+  static const GLuint VISIBILITY_BINDING = 2;
+  static const GLuint COMMANDS_BINDING = 3;
+  static const GLuint TEXTURE_UNIT = 0;
+  static const GLuint IMAGE_UNIT = 0;
+  static const int LATENCY = 4;
+
+  // std430 layout of the cull shader. Commands [FirstCommand, FirstCommand +
+  // CommandCount) of the indirect buffer draw the box with one instance;
+  // boxes drawn from the CPU have none.
+  struct Box {
+    glm::vec4 Min, Max; // w unused
+    GLuint FirstCommand, CommandCount;
+    GLuint InFrustum, Padding;
+  };
+
+  OcclusionCuller();
+  ~OcclusionCuller();
+  OcclusionCuller(const OcclusionCuller &) = delete;
+  OcclusionCuller &operator=(const OcclusionCuller &) = delete;
+
+  void create(const std::string &reduce_shader, const std::string &cull_shader);
+  // Matches the pyramid to the viewport; call on window resize.
+  void resize(const GLsizei width, const GLsizei height);
+  void buildPyramid();
+  // Uploads the boxes of this frame. Resetting (or changing the number of
+  // boxes) drops the history: every box counts as visible at the last test.
+  void setBoxes(const std::vector<Box> &boxes, const bool reset);
+  // Phase 1: one instance for the boxes in the frustum that were visible at
+  // the last test, none for the others. command_buffer may be 0.
+  void selectPrevious(const GLuint command_buffer);
+  // Phase 2: tests every box against the pyramid rendered with
+  // view_projection, selects the boxes in the frustum that became visible and
+  // records the result for the next frame and for getVisibility().
+  void selectVisible(const GLuint command_buffer,
+                     const glm::mat4 &view_projection);
+  // visible[i] of the latest test the GPU has completed since the last reset
+  // (false, leaving visible untouched, until one arrives). Never stalls.
+  bool getVisibility(std::vector<unsigned char> &visible);
+  // Boxes with draw commands in the frustum that the same test hid (counted
+  // on the GPU, 0 until a result arrives).
+  unsigned int getHidden();
+
+  GLuint getPyramid() const { return Pyramid; }
+  int getLevels() const { return Levels; }
+
+private:
+  ShaderProgram Reduce, Cull;
+  GLint SourceLevelSlot, ViewProjectionSlot, BoxCountSlot, PhaseSlot,
+      HasPreviousSlot;
+  GLuint DepthTexture, Pyramid, BoxBuffer;
+  GLsizei Width, Height;
+  int Levels;
+  size_t TextureBytes;
+
+  // Visibility ring: the slot written by the last test is read by the next
+  // phase 1 on the GPU and, once its fence signals, by the CPU. Each slot
+  // starts with the hidden counter, followed by one value per box.
+  GLuint Slots[LATENCY];
+  GLsync Fences[LATENCY];
+  bool Pending[LATENCY];
+  int Current, Previous;
+  bool HasPrevious, Available;
+  size_t Count, Capacity;
+  std::vector<GLuint> Readback;
+
+  void destroyTextures();
+  void resetHistory(const size_t count);
+  void bindStorage(const GLuint binding, const GLuint buffer);
+  void dispatch(const int phase, const GLuint command_buffer);
+  void collect(const bool wait_for_oldest);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_OCCLUSION_CULLER_HPP */
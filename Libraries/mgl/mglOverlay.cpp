@@ -0,0 +1,267 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Screen Overlay Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglOverlay.hpp"
+
+#include <cstddef>
+
+#include "./mglGpuMemory.hpp"
+#include "./mglStateCache.hpp"
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////////////// Overlay
+
+namespace {
+// ASCII 32..95, one row of 5 bits per byte, top row first.
+const unsigned char Font[64][7] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // space
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, // !
+    {0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00}, // "
+    {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A}, // #
+    {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04}, // $
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, // %
+    {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D}, // &
+    {0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00}, // '
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, // (
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, // )
+    {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00}, // *
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}, // +
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}, // ,
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // -
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // .
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // /
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // 0
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 1
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // 2
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // 3
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // 4
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // 5
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // 6
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // 7
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // 8
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // 9
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // :
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08}, // ;
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}, // <
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}, // =
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}, // >
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}, // ?
+    {0x0E, 0x11, 0x17, 0x15, 0x17, 0x10, 0x0E}, // @
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // A
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // B
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // C
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // D
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // E
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // F
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // G
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // H
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // I
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // J
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // K
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // L
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // M
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // N
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // O
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // P
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // Q
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // R
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // S
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // T
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // U
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // V
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // W
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // X
+    {0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04}, // Y
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // Z
+    {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E}, // [
+    {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00}, // backslash
+    {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E}, // ]
+    {0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00}, // ^
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F}, // _
+};
+
+// The atlas has 8x8 cells of (ADVANCE x LINE_HEIGHT) texels, glyph in the
+// top left corner. The bottom right texel of the space glyph is solid and
+// gives quads a constant coverage.
+const int CELL_WIDTH = 6;
+const int CELL_HEIGHT = 8;
+const int ATLAS_WIDTH = 8 * CELL_WIDTH;
+const int ATLAS_HEIGHT = 8 * CELL_HEIGHT;
+const glm::vec2 SolidTexel((CELL_WIDTH - 0.5f) / ATLAS_WIDTH,
+                           (CELL_HEIGHT - 0.5f) / ATLAS_HEIGHT);
+} // namespace
+
+const int Overlay::GLYPH_WIDTH;
+const int Overlay::GLYPH_HEIGHT;
+const int Overlay::ADVANCE;
+const int Overlay::LINE_HEIGHT;
+const GLuint Overlay::POSITION;
+const GLuint Overlay::TEXCOORD;
+const GLuint Overlay::COLOR;
+const GLuint Overlay::TEXTURE_UNIT;
+
+Overlay::Overlay()
+    : ScreenSizeSlot(-1), Vao(0), Buffer(0), Atlas(0), ScreenSize(1.0f) {}
+
+Overlay::~Overlay() { destroy(); }
+
+void Overlay::create(const std::string &vertex_shader,
+                     const std::string &fragment_shader) {
+  Shaders.addShader(GL_VERTEX_SHADER, vertex_shader);
+  Shaders.addShader(GL_FRAGMENT_SHADER, fragment_shader);
+  Shaders.enableIntrospection();
+  Shaders.create();
+  ScreenSizeSlot = Shaders.getUniformSlot("screenSize");
+
+  StateCache &cache = StateCache::getInstance();
+  glGenVertexArrays(1, &Vao);
+  glGenBuffers(1, &Buffer);
+  cache.bindVertexArray(Vao);
+  cache.bindBuffer(GL_ARRAY_BUFFER, Buffer);
+  glEnableVertexAttribArray(POSITION);
+  glVertexAttribPointer(POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        reinterpret_cast<const void *>(
+                            offsetof(Vertex, Position)));
+  glEnableVertexAttribArray(TEXCOORD);
+  glVertexAttribPointer(TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        reinterpret_cast<const void *>(
+                            offsetof(Vertex, Texcoord)));
+  glEnableVertexAttribArray(COLOR);
+  glVertexAttribPointer(COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        reinterpret_cast<const void *>(offsetof(Vertex, Color)));
+  cache.bindVertexArray(0);
+  cache.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+  createAtlas();
+}
+
+void Overlay::createAtlas() {
+  std::vector<unsigned char> texels(ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+  for (int glyph = 0; glyph < 64; glyph++) {
+    const int x0 = (glyph % 8) * CELL_WIDTH;
+    const int y0 = (glyph / 8) * CELL_HEIGHT;
+    for (int row = 0; row < GLYPH_HEIGHT; row++)
+      for (int column = 0; column < GLYPH_WIDTH; column++)
+        if (Font[glyph][row] & (0x10 >> column))
+          texels[(y0 + row) * ATLAS_WIDTH + x0 + column] = 255;
+  }
+  texels[(CELL_HEIGHT - 1) * ATLAS_WIDTH + CELL_WIDTH - 1] = 255;
+
+  StateCache &cache = StateCache::getInstance();
+  glGenTextures(1, &Atlas);
+  cache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, Atlas);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, ATLAS_WIDTH, ATLAS_HEIGHT, GL_RED,
+                  GL_UNSIGNED_BYTE, texels.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  GpuMemory::getInstance().allocate(GpuMemory::TEXTURES, texels.size());
+}
+
+void Overlay::destroy() {
+  if (Atlas) {
+    StateCache::getInstance().bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &Atlas);
+    GpuMemory::getInstance().release(GpuMemory::TEXTURES,
+                                     ATLAS_WIDTH * ATLAS_HEIGHT);
+    Atlas = 0;
+  }
+  if (Buffer) {
+    glDeleteBuffers(1, &Buffer);
+    Buffer = 0;
+  }
+  if (Vao) {
+    StateCache::getInstance().bindVertexArray(0);
+    glDeleteVertexArrays(1, &Vao);
+    Vao = 0;
+  }
+}
+
+void Overlay::begin(const GLsizei width, const GLsizei height) {
+  ScreenSize = glm::vec2(float(width), float(height));
+  Vertices.clear();
+}
+
+// Two counter-clockwise triangles once y is flipped to clip space.
+void Overlay::addQuad(const glm::vec2 &position, const glm::vec2 &size,
+                      const glm::vec2 &uv0, const glm::vec2 &uv1,
+                      const glm::vec4 &color) {
+  const Vertex a = {position, uv0, color};
+  const Vertex b = {position + glm::vec2(0.0f, size.y),
+                    glm::vec2(uv0.x, uv1.y), color};
+  const Vertex c = {position + size, uv1, color};
+  const Vertex d = {position + glm::vec2(size.x, 0.0f),
+                    glm::vec2(uv1.x, uv0.y), color};
+  Vertices.push_back(a);
+  Vertices.push_back(b);
+  Vertices.push_back(c);
+  Vertices.push_back(a);
+  Vertices.push_back(c);
+  Vertices.push_back(d);
+}
+
+void Overlay::quad(const float x, const float y, const float width,
+                   const float height, const glm::vec4 &color) {
+  addQuad(glm::vec2(x, y), glm::vec2(width, height), SolidTexel, SolidTexel,
+          color);
+}
+
+float Overlay::text(const float x, const float y, const std::string &text,
+                    const glm::vec4 &color, const float scale) {
+  const glm::vec2 size(GLYPH_WIDTH * scale, GLYPH_HEIGHT * scale);
+  const glm::vec2 extent(float(GLYPH_WIDTH) / ATLAS_WIDTH,
+                         float(GLYPH_HEIGHT) / ATLAS_HEIGHT);
+  float pen = x;
+  for (char c : text) {
+    if (c >= 'a' && c <= 'z')
+      c = char(c - 'a' + 'A');
+    if (c < ' ' || c > '_')
+      c = '?';
+    if (c != ' ') {
+      const int glyph = c - ' ';
+      const glm::vec2 uv0(float((glyph % 8) * CELL_WIDTH) / ATLAS_WIDTH,
+                          float((glyph / 8) * CELL_HEIGHT) / ATLAS_HEIGHT);
+      addQuad(glm::vec2(pen, y), size, uv0, uv0 + extent, color);
+    }
+    pen += ADVANCE * scale;
+  }
+  return pen - x;
+}
+
+void Overlay::end() {
+  if (Vertices.empty())
+    return;
+  StateCache &cache = StateCache::getInstance();
+  cache.bindBuffer(GL_ARRAY_BUFFER, Buffer);
+  // Orphans last frame's storage instead of waiting for it.
+  glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * Vertices.size(),
+               Vertices.data(), GL_STREAM_DRAW);
+  cache.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+  cache.setEnabled(GL_DEPTH_TEST, false);
+  cache.setEnabled(GL_BLEND, true);
+  cache.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  Shaders.bind();
+  Shaders.setUniform(ScreenSizeSlot, ScreenSize);
+  cache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D, Atlas);
+  cache.bindVertexArray(Vao);
+  glDrawArrays(GL_TRIANGLES, 0, GLsizei(Vertices.size()));
+  cache.bindVertexArray(0);
+  Shaders.unbind();
+  cache.setEnabled(GL_BLEND, false);
+  cache.setEnabled(GL_DEPTH_TEST, true);
+  Vertices.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Screen Overlay Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_OVERLAY_HPP
+#define MGL_OVERLAY_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+class Overlay;
+
+//////////////////////////////////////////////////////////////////////// Overlay
+
+// Batches solid quads and text in window pixels (origin at the top left)
+// and draws them in one call on top of the frame. Text uses a built-in 5x7
+// font for ASCII 32..95; lowercase letters are drawn as uppercase and other
+// characters as '?'. Meant for debug displays, not for UI.
+
+class Overlay final {
+public:
+  static const int GLYPH_WIDTH = 5;
+  static const int GLYPH_HEIGHT = 7;
+  static const int ADVANCE = 6;     // pixels per character at scale 1
+  static const int LINE_HEIGHT = 9; // pixels per line at scale 1
+  // Must match the shaders.
+  static const GLuint POSITION = 0;
+  static const GLuint TEXCOORD = 1;
+  static const GLuint COLOR = 2;
+  static const GLuint TEXTURE_UNIT = 0;
+
+  Overlay();
+  ~Overlay();
+  Overlay(const Overlay &) = delete;
+  Overlay &operator=(const Overlay &) = delete;
+
+  void create(const std::string &vertex_shader,
+              const std::string &fragment_shader);
+  void destroy();
+
+  // Starts a batch for a window of the given size.
+  void begin(const GLsizei width, const GLsizei height);
+  void quad(const float x, const float y, const float width,
+            const float height, const glm::vec4 &color);
+  // Returns the width of the text in pixels.
+  float text(const float x, const float y, const std::string &text,
+             const glm::vec4 &color, const float scale = 1.0f);
+  // Draws the batch with depth testing off and alpha blending, and leaves
+  // depth testing on and blending off as the Engine sets them up.
+  void end();
+
+private:
+  struct Vertex {
+    glm::vec2 Position;
+    glm::vec2 Texcoord;
+    glm::vec4 Color;
+  };
+
+  ShaderProgram Shaders;
+  GLint ScreenSizeSlot;
+  GLuint Vao, Buffer, Atlas;
+  glm::vec2 ScreenSize;
+  std::vector<Vertex> Vertices;
+
+  void addQuad(const glm::vec2 &position, const glm::vec2 &size,
+               const glm::vec2 &uv0, const glm::vec2 &uv1,
+               const glm::vec4 &color);
+  void createAtlas();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_OVERLAY_HPP */
@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Object Pool Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_POOL_HPP
+#define MGL_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mgl {
+
+template <typename T> class Pool;
+
+/////////////////////////////////////////////////////////////////////////// Pool
+
+// Objects stored by value in one contiguous array of slots. Destroyed slots
+// go to a free list and are reused, so create and destroy are O(1) and
+// allocate nothing once the pool has grown. Handles carry the generation of
+// their slot: a handle to a destroyed object stays invalid even after its
+// slot is reused. clear() destroys everything at once and keeps the memory.
+
+template <typename T> class Pool final {
+public:
+  struct Handle {
+    uint32_t Index = INVALID;
+    uint32_t Generation = 0;
+    bool operator==(const Handle &other) const {
+      return Index == other.Index && Generation == other.Generation;
+    }
+    bool operator!=(const Handle &other) const { return !(*this == other); }
+  };
+
+  static const uint32_t INVALID = ~0u;
+
+  void reserve(const size_t capacity) {
+    if (capacity > Items.capacity()) {
+      Items.reserve(capacity);
+      Growths++;
+    }
+    Generations.reserve(capacity);
+    Alive.reserve(capacity);
+    FreeSlots.reserve(capacity);
+  }
+
+  Handle create(const T &value = T()) { return createAfter(value, INVALID); }
+
+  // The slot index will be greater than `after` (or any slot if INVALID):
+  // keeps e.g. parents before children. A free slot that does not qualify
+  // is left for a later create.
+  Handle createAfter(const T &value, const uint32_t after) {
+    uint32_t index;
+    if (!FreeSlots.empty() &&
+        (after == INVALID || FreeSlots.back() > after)) {
+      index = FreeSlots.back();
+      FreeSlots.pop_back();
+      Items[index] = value;
+    } else {
+      index = uint32_t(Items.size());
+      const size_t capacity = Items.capacity();
+      Items.push_back(value);
+      if (Items.capacity() != capacity)
+        Growths++;
+      if (index == Generations.size()) {
+        Generations.push_back(0);
+        Alive.push_back(0);
+      }
+    }
+    Alive[index] = 1;
+    Live++;
+    Handle handle;
+    handle.Index = index;
+    handle.Generation = Generations[index];
+    return handle;
+  }
+
+  // Resets the slot to T() so that it releases what it holds.
+  bool destroy(const Handle handle) {
+    if (!isValid(handle))
+      return false;
+    Items[handle.Index] = T();
+    Generations[handle.Index]++;
+    Alive[handle.Index] = 0;
+    FreeSlots.push_back(handle.Index);
+    Live--;
+    return true;
+  }
+
+  // Generations survive clear() so that old handles stay invalid.
+  void clear() {
+    for (size_t i = 0; i < Items.size(); i++) {
+      if (Alive[i]) {
+        Generations[i]++;
+        Alive[i] = 0;
+      }
+    }
+    Items.clear();
+    FreeSlots.clear();
+    Live = 0;
+  }
+
+  bool isValid(const Handle handle) const {
+    return handle.Index < Items.size() && Alive[handle.Index] &&
+           Generations[handle.Index] == handle.Generation;
+  }
+
+  T *get(const Handle handle) {
+    return isValid(handle) ? &Items[handle.Index] : nullptr;
+  }
+  const T *get(const Handle handle) const {
+    return isValid(handle) ? &Items[handle.Index] : nullptr;
+  }
+
+  // Direct slot access for linear passes; dead slots hold T().
+  T &operator[](const size_t index) { return Items[index]; }
+  const T &operator[](const size_t index) const { return Items[index]; }
+  bool isAlive(const size_t index) const { return Alive[index] != 0; }
+  Handle getHandle(const size_t index) const {
+    Handle handle;
+    if (index < Items.size() && Alive[index]) {
+      handle.Index = uint32_t(index);
+      handle.Generation = Generations[index];
+    }
+    return handle;
+  }
+
+  size_t size() const { return Live; }
+  size_t getSlotCount() const { return Items.size(); }
+  // Times the slot array was reallocated, to check that steady-state
+  // create/destroy does not allocate.
+  size_t getGrowthCount() const { return Growths; }
+
+private:
+  std::vector<T> Items;
+  std::vector<uint32_t> Generations;
+  std::vector<unsigned char> Alive;
+  std::vector<uint32_t> FreeSlots;
+  size_t Live = 0;
+  size_t Growths = 0;
+};
+
+template <typename T> const uint32_t Pool<T>::INVALID;
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_POOL_HPP */
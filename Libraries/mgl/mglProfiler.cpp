@@ -0,0 +1,360 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Profiler Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglProfiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace mgl {
+
+/////////////////////////////////////////////////////////////////////// Profiler
+
+namespace {
+struct OpenScope {
+  const char *Name;
+  double Start;
+};
+// Each thread nests its own scopes.
+thread_local std::vector<OpenScope> OpenScopes;
+} // namespace
+
+const size_t Profiler::HISTORY;
+const int Profiler::GPU_LATENCY;
+const size_t Profiler::MAX_EVENTS;
+
+Profiler::Profiler()
+    : Enabled(true), Capturing(false),
+      Origin(std::chrono::steady_clock::now()), FrameStart(0.0),
+      ActiveGpu(GpuTimers.end()), GpuActive(false) {
+  Tracks[std::this_thread::get_id()] = 0;
+  TrackNames.push_back("CPU");
+  TrackNames.push_back("GPU");
+}
+
+Profiler &Profiler::getInstance() {
+  static Profiler instance;
+  return instance;
+}
+
+double Profiler::now() const {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - Origin)
+      .count();
+}
+
+void Profiler::setEnabled(const bool enabled) {
+  if (!OpenScopes.empty() || GpuActive)
+    throw std::runtime_error("Profiler scope still open.");
+  Enabled = enabled;
+}
+
+void Profiler::Series::add(const double ms) {
+  if (Samples.size() < HISTORY) {
+    Samples.push_back(ms);
+  } else {
+    Samples[Next] = ms;
+    Next = (Next + 1) % HISTORY;
+  }
+}
+
+// Called with Lock held.
+int Profiler::currentTrack() {
+  auto it = Tracks.find(std::this_thread::get_id());
+  if (it != Tracks.end())
+    return it->second;
+  const int track = int(TrackNames.size());
+  Tracks[std::this_thread::get_id()] = track;
+  TrackNames.push_back("Thread " + std::to_string(track));
+  return track;
+}
+
+void Profiler::setThreadName(const std::string &name) {
+  std::lock_guard<std::mutex> guard(Lock);
+  TrackNames[currentTrack()] = name;
+}
+
+void Profiler::record(std::map<std::string, Series> &series,
+                      const std::string &name, const double start,
+                      const double duration, int track) {
+  std::lock_guard<std::mutex> guard(Lock);
+  series[name].add(duration / 1000.0);
+  if (Capturing && Events.size() < MAX_EVENTS) {
+    if (track < 0)
+      track = currentTrack();
+    Events.push_back(Event{name, start, duration, track});
+  }
+}
+
+void Profiler::addSample(const std::string &name, const double ms) {
+  std::lock_guard<std::mutex> guard(Lock);
+  CpuSeries[name].add(ms);
+}
+
+////////////////////////////////////////////////////////////////////// Frames
+
+void Profiler::beginFrame() {
+  if (Enabled)
+    FrameStart = now();
+}
+
+void Profiler::endFrame() {
+  if (!Enabled)
+    return;
+  record(CpuSeries, "Frame", FrameStart, now() - FrameStart, 0);
+  for (auto &timer : GpuTimers)
+    collectGpu(timer.first, timer.second);
+}
+
+////////////////////////////////////////////////////////////////////// Scopes
+
+void Profiler::beginScope(const char *name) {
+  OpenScopes.push_back(OpenScope{name, now()});
+}
+
+void Profiler::endScope() {
+  if (OpenScopes.empty())
+    throw std::runtime_error("No profiler scope open.");
+  const OpenScope scope = OpenScopes.back();
+  OpenScopes.pop_back();
+  record(CpuSeries, scope.Name, scope.Start, now() - scope.Start, -1);
+}
+
+// Reusing a slot whose result is not back yet waits for it; with
+// GPU_LATENCY frames in flight this only happens if the GPU falls behind.
+void Profiler::beginGpuScope(const char *name) {
+  if (GpuActive)
+    throw std::runtime_error("GPU profiler scopes cannot nest.");
+  auto it = GpuTimers.find(name);
+  if (it == GpuTimers.end()) {
+    GpuTimer timer;
+    glGenQueries(GPU_LATENCY, timer.Ids);
+    for (int i = 0; i < GPU_LATENCY; i++) {
+      timer.Submitted[i] = 0.0;
+      timer.Pending[i] = false;
+    }
+    timer.Current = 0;
+    it = GpuTimers.insert(std::make_pair(std::string(name), timer)).first;
+  }
+  GpuTimer &timer = it->second;
+  if (timer.Pending[timer.Current])
+    readGpuResult(it->first, timer, timer.Current);
+  timer.Submitted[timer.Current] = now();
+  glBeginQuery(GL_TIME_ELAPSED, timer.Ids[timer.Current]);
+  ActiveGpu = it;
+  GpuActive = true;
+}
+
+void Profiler::endGpuScope() {
+  if (!GpuActive)
+    throw std::runtime_error("No GPU profiler scope open.");
+  glEndQuery(GL_TIME_ELAPSED);
+  GpuTimer &timer = ActiveGpu->second;
+  timer.Pending[timer.Current] = true;
+  timer.Current = (timer.Current + 1) % GPU_LATENCY;
+  GpuActive = false;
+}
+
+void Profiler::readGpuResult(const std::string &name, GpuTimer &timer,
+                             const int index) {
+  GLuint64 elapsed = 0;
+  glGetQueryObjectui64v(timer.Ids[index], GL_QUERY_RESULT, &elapsed);
+  timer.Pending[index] = false;
+  record(GpuSeries, name, timer.Submitted[index], double(elapsed) / 1000.0,
+         1);
+}
+
+// Queries complete in order: read from the oldest and stop at the first
+// result that is not available yet.
+void Profiler::collectGpu(const std::string &name, GpuTimer &timer) {
+  for (int i = 0; i < GPU_LATENCY; i++) {
+    const int index = (timer.Current + i) % GPU_LATENCY;
+    if (!timer.Pending[index])
+      continue;
+    GLuint ready = GL_FALSE;
+    glGetQueryObjectuiv(timer.Ids[index], GL_QUERY_RESULT_AVAILABLE, &ready);
+    if (!ready)
+      break;
+    readGpuResult(name, timer, index);
+  }
+}
+
+void Profiler::destroyGpuTimers() {
+  for (auto &timer : GpuTimers)
+    glDeleteQueries(GPU_LATENCY, timer.second.Ids);
+  GpuTimers.clear();
+  ActiveGpu = GpuTimers.end();
+  GpuActive = false;
+}
+
+/////////////////////////////////////////////////////////////////// Statistics
+
+Profiler::Stats
+Profiler::computeStats(const std::map<std::string, Series> &series,
+                       const std::string &name) {
+  Stats stats;
+  auto it = series.find(name);
+  if (it == series.end() || it->second.Samples.empty())
+    return stats;
+  std::vector<double> sorted = it->second.Samples;
+  std::sort(sorted.begin(), sorted.end());
+  const size_t n = sorted.size();
+  double sum = 0.0;
+  for (double sample : sorted)
+    sum += sample;
+  stats.Count = n;
+  stats.Mean = sum / double(n);
+  stats.P50 = sorted[(n - 1) * 50 / 100];
+  stats.P95 = sorted[(n - 1) * 95 / 100];
+  stats.P99 = sorted[(n - 1) * 99 / 100];
+  double variance = 0.0;
+  for (double sample : sorted)
+    variance += (sample - stats.Mean) * (sample - stats.Mean);
+  stats.StdDev = std::sqrt(variance / double(n));
+  return stats;
+}
+
+Profiler::Stats Profiler::getStats(const std::string &name) const {
+  std::lock_guard<std::mutex> guard(Lock);
+  return computeStats(CpuSeries, name);
+}
+
+Profiler::Stats Profiler::getGpuStats(const std::string &name) const {
+  std::lock_guard<std::mutex> guard(Lock);
+  return computeStats(GpuSeries, name);
+}
+
+std::vector<std::string> Profiler::getScopeNames() const {
+  std::lock_guard<std::mutex> guard(Lock);
+  std::vector<std::string> names;
+  for (const auto &series : CpuSeries)
+    names.push_back(series.first);
+  return names;
+}
+
+std::vector<std::string> Profiler::getGpuScopeNames() const {
+  std::lock_guard<std::mutex> guard(Lock);
+  std::vector<std::string> names;
+  for (const auto &series : GpuSeries)
+    names.push_back(series.first);
+  return names;
+}
+
+void Profiler::printStats(std::ostream &out) const {
+  std::lock_guard<std::mutex> guard(Lock);
+  const std::ios::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+  out << std::fixed << std::setprecision(3);
+  out << "      scope                      mean      p50      p95      p99   "
+         "stddev (ms)\n";
+  const std::map<std::string, Series> *all[] = {&CpuSeries, &GpuSeries};
+  const char *labels[] = {"cpu", "gpu"};
+  for (int k = 0; k < 2; k++) {
+    for (const auto &series : *all[k]) {
+      const Stats stats = computeStats(*all[k], series.first);
+      out << "  " << labels[k] << " " << std::left << std::setw(24)
+          << series.first << std::right << std::setw(9) << stats.Mean
+          << std::setw(9) << stats.P50 << std::setw(9) << stats.P95
+          << std::setw(9) << stats.P99 << std::setw(9) << stats.StdDev
+          << "\n";
+    }
+  }
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void Profiler::clear() {
+  std::lock_guard<std::mutex> guard(Lock);
+  CpuSeries.clear();
+  GpuSeries.clear();
+  Events.clear();
+}
+
+/////////////////////////////////////////////////////////////////// Chrome trace
+
+void Profiler::startCapture() {
+  std::lock_guard<std::mutex> guard(Lock);
+  Events.clear();
+  Capturing = true;
+}
+
+void Profiler::stopCapture() {
+  std::lock_guard<std::mutex> guard(Lock);
+  Capturing = false;
+}
+
+static void writeJsonString(std::ostream &out, const std::string &text) {
+  out << '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      out << '\\' << c;
+    else if (static_cast<unsigned char>(c) < 0x20)
+      out << ' ';
+    else
+      out << c;
+  }
+  out << '"';
+}
+
+// Complete ("X") events in microseconds. GPU events are placed at the CPU
+// time their query was issued, on a separate track.
+void Profiler::writeChromeTrace(const std::string &filename) const {
+  std::lock_guard<std::mutex> guard(Lock);
+  std::ofstream file(filename);
+  if (!file)
+    throw std::runtime_error("Cannot write " + filename);
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (size_t track = 0; track < TrackNames.size(); track++) {
+    file << (track ? ",\n" : "\n")
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+         << track << ",\"args\":{\"name\":";
+    writeJsonString(file, TrackNames[track]);
+    file << "}}";
+  }
+  for (const Event &event : Events) {
+    file << ",\n{\"name\":";
+    writeJsonString(file, event.Name);
+    file << ",\"cat\":\"" << (event.Track == 1 ? "gpu" : "cpu")
+         << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.Track
+         << ",\"ts\":" << event.Start << ",\"dur\":" << event.Duration << "}";
+  }
+  file << "\n]}\n";
+}
+
+/////////////////////////////////////////////////////////////////// ProfileScope
+
+ProfileScope::ProfileScope(const char *name)
+    : Active(Profiler::getInstance().isEnabled()) {
+  if (Active)
+    Profiler::getInstance().beginScope(name);
+}
+
+ProfileScope::~ProfileScope() {
+  if (Active)
+    Profiler::getInstance().endScope();
+}
+
+//////////////////////////////////////////////////////////////// GpuProfileScope
+
+GpuProfileScope::GpuProfileScope(const char *name)
+    : Active(Profiler::getInstance().isEnabled()) {
+  if (Active)
+    Profiler::getInstance().beginGpuScope(name);
+}
+
+GpuProfileScope::~GpuProfileScope() {
+  if (Active)
+    Profiler::getInstance().endGpuScope();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
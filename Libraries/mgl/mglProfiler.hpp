@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame Profiler Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_PROFILER_HPP
+#define MGL_PROFILER_HPP
+
+#include <GL/glew.h>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mgl {
+
+class Profiler;
+class ProfileScope;
+class GpuProfileScope;
+
+/////////////////////////////////////////////////////////////////////// Profiler
+
+// Named CPU scopes (may nest) and GPU scopes timed with GL_TIME_ELAPSED
+// queries (may not nest or overlap). Each name keeps its last HISTORY
+// samples for rolling statistics. GPU results are read a few frames late so
+// that profiling does not stall the pipeline. While capturing, every scope
+// is also recorded as an event for a Chrome trace (chrome://tracing or
+// Perfetto). The Engine marks the frames. CPU scopes may be used on any
+// thread (each thread gets its own trace track); frames and GPU scopes
+// belong to the thread that owns the GL context.
+
+class Profiler final {
+public:
+  static const size_t HISTORY = 256;
+  static const int GPU_LATENCY = 4;
+  static const size_t MAX_EVENTS = 1 << 20;
+
+  struct Stats {
+    double Mean = 0.0, P50 = 0.0, P95 = 0.0, P99 = 0.0; // milliseconds
+    double StdDev = 0.0;
+    size_t Count = 0;
+  };
+
+  static Profiler &getInstance();
+
+  void setEnabled(const bool enabled);
+  bool isEnabled() const { return Enabled; }
+
+  void beginFrame();
+  void endFrame();
+
+  void beginScope(const char *name);
+  void endScope();
+  void beginGpuScope(const char *name);
+  void endGpuScope();
+  // A value measured elsewhere (e.g. a latency), kept like a scope duration.
+  void addSample(const std::string &name, const double ms);
+  // Names the calling thread's track in the trace.
+  void setThreadName(const std::string &name);
+
+  // "Frame" is the CPU time between beginFrame() and endFrame().
+  Stats getStats(const std::string &name) const;
+  Stats getGpuStats(const std::string &name) const;
+  void printStats(std::ostream &out) const;
+  // Names with recorded samples, in alphabetical order.
+  std::vector<std::string> getScopeNames() const;
+  std::vector<std::string> getGpuScopeNames() const;
+
+  void startCapture();
+  void stopCapture();
+  bool isCapturing() const { return Capturing; }
+  void writeChromeTrace(const std::string &filename) const;
+
+  // Drops all samples and events.
+  void clear();
+  // Deletes the GPU queries; call while the context is still current.
+  void destroyGpuTimers();
+
+private:
+  struct Series {
+    std::vector<double> Samples;
+    size_t Next = 0;
+    void add(const double ms);
+  };
+
+  struct Event {
+    std::string Name;
+    double Start, Duration; // microseconds since the profiler started
+    int Track;              // 0 = GL thread, 1 = GPU, then other threads
+  };
+
+  struct GpuTimer {
+    GLuint Ids[GPU_LATENCY];
+    double Submitted[GPU_LATENCY];
+    bool Pending[GPU_LATENCY];
+    int Current;
+  };
+
+  bool Enabled, Capturing;
+  std::chrono::steady_clock::time_point Origin;
+  double FrameStart;
+  mutable std::mutex Lock; // series, events and tracks
+  std::map<std::thread::id, int> Tracks;
+  std::vector<std::string> TrackNames;
+  std::map<std::string, Series> CpuSeries, GpuSeries;
+  std::map<std::string, GpuTimer> GpuTimers;
+  std::map<std::string, GpuTimer>::iterator ActiveGpu;
+  bool GpuActive;
+  std::vector<Event> Events;
+
+  Profiler();
+  ~Profiler() = default;
+  double now() const;
+  // A negative track stands for the calling thread's.
+  void record(std::map<std::string, Series> &series, const std::string &name,
+              const double start, const double duration, int track);
+  int currentTrack();
+  void readGpuResult(const std::string &name, GpuTimer &timer,
+                     const int index);
+  void collectGpu(const std::string &name, GpuTimer &timer);
+  static Stats computeStats(const std::map<std::string, Series> &series,
+                            const std::string &name);
+
+public:
+  Profiler(Profiler const &) = delete;
+  void operator=(Profiler const &) = delete;
+};
+
+/////////////////////////////////////////////////////////////////// ProfileScope
+
+class ProfileScope final {
+public:
+  explicit ProfileScope(const char *name);
+  ~ProfileScope();
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+  bool Active;
+};
+
+//////////////////////////////////////////////////////////////// GpuProfileScope
+
+class GpuProfileScope final {
+public:
+  explicit GpuProfileScope(const char *name);
+  ~GpuProfileScope();
+  GpuProfileScope(const GpuProfileScope &) = delete;
+  GpuProfileScope &operator=(const GpuProfileScope &) = delete;
+
+private:
+  bool Active;
+};
+
+#define MGL_PROFILE_CONCAT_(a, b) a##b
+#define MGL_PROFILE_CONCAT(a, b) MGL_PROFILE_CONCAT_(a, b)
+// Times the rest of the enclosing block.
+#define MGL_PROFILE_SCOPE(name)                                                \
+  mgl::ProfileScope MGL_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define MGL_PROFILE_GPU(name)                                                  \
+  mgl::GpuProfileScope MGL_PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_PROFILER_HPP */
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Program Pipeline Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglProgramPipeline.hpp"
+
+#include <iostream>
+#include <vector>
+
+#include "./mglStateCache.hpp"
+
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////// ProgramPipeline
+
+static const GLbitfield STAGE_BITS[] = {
+    GL_VERTEX_SHADER_BIT,   GL_TESS_CONTROL_SHADER_BIT,
+    GL_TESS_EVALUATION_SHADER_BIT, GL_GEOMETRY_SHADER_BIT,
+    GL_FRAGMENT_SHADER_BIT, GL_COMPUTE_SHADER_BIT};
+
+GLbitfield ProgramPipeline::stageBit(const GLenum shader_type) {
+  switch (shader_type) {
+  case GL_VERTEX_SHADER:
+    return GL_VERTEX_SHADER_BIT;
+  case GL_TESS_CONTROL_SHADER:
+    return GL_TESS_CONTROL_SHADER_BIT;
+  case GL_TESS_EVALUATION_SHADER:
+    return GL_TESS_EVALUATION_SHADER_BIT;
+  case GL_GEOMETRY_SHADER:
+    return GL_GEOMETRY_SHADER_BIT;
+  case GL_FRAGMENT_SHADER:
+    return GL_FRAGMENT_SHADER_BIT;
+  case GL_COMPUTE_SHADER:
+    return GL_COMPUTE_SHADER_BIT;
+  default:
+    return 0;
+  }
+}
+
+ProgramPipeline::ProgramPipeline() : Programs() {
+  glGenProgramPipelines(1, &PipelineId);
+}
+
+ProgramPipeline::~ProgramPipeline() {
+  StateCache::getInstance().bindProgramPipeline(0);
+  glDeleteProgramPipelines(1, &PipelineId);
+}
+
+void ProgramPipeline::useProgramStages(const GLbitfield stages,
+                                       ShaderProgram *program) {
+  glUseProgramStages(PipelineId, stages, program ? program->ProgramId : 0);
+  for (int i = 0; i < STAGES; i++) {
+    if (stages & STAGE_BITS[i])
+      Programs[i] = program;
+  }
+}
+
+ShaderProgram *ProgramPipeline::getProgram(const GLbitfield stage) const {
+  for (int i = 0; i < STAGES; i++) {
+    if (stage == STAGE_BITS[i])
+      return Programs[i];
+  }
+  return nullptr;
+}
+
+bool ProgramPipeline::validate() {
+  glValidateProgramPipeline(PipelineId);
+  GLint valid;
+  glGetProgramPipelineiv(PipelineId, GL_VALIDATE_STATUS, &valid);
+  if (valid == GL_FALSE) {
+    GLint length;
+    glGetProgramPipelineiv(PipelineId, GL_INFO_LOG_LENGTH, &length);
+    std::vector<char> log(length + 1);
+    glGetProgramPipelineInfoLog(PipelineId, length, &length, log.data());
+    std::cerr << "[PIPELINE] " << std::endl << log.data() << std::endl;
+  }
+  return valid == GL_TRUE;
+}
+
+// A program bound with glUseProgram overrides the bound pipeline.
+void ProgramPipeline::bind() {
+  StateCache &cache = StateCache::getInstance();
+  cache.useProgram(0);
+  cache.bindProgramPipeline(PipelineId);
+}
+
+void ProgramPipeline::unbind() {
+  StateCache::getInstance().bindProgramPipeline(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
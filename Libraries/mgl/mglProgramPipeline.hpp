@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Program Pipeline Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_PROGRAM_PIPELINE_HPP
+#define MGL_PROGRAM_PIPELINE_HPP
+
+#include <GL/glew.h>
+
+#include <string>
+
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+class ProgramPipeline;
+
+//////////////////////////////////////////////////////////////// ProgramPipeline
+
+// Combines separable ShaderPrograms (one per stage) so a stage compiled once
+// can be paired with any other. Programs are not owned by the pipeline.
+
+class ProgramPipeline final {
+public:
+  GLuint PipelineId;
+
+  ProgramPipeline();
+  ~ProgramPipeline();
+
+  ProgramPipeline(const ProgramPipeline &) = delete;
+  ProgramPipeline &operator=(const ProgramPipeline &) = delete;
+
+  static GLbitfield stageBit(const GLenum shader_type);
+
+  void useProgramStages(const GLbitfield stages, ShaderProgram *program);
+  ShaderProgram *getProgram(const GLbitfield stage) const;
+  bool validate();
+  void bind();
+  void unbind();
+
+  // Sets the uniform in every stage program where it is active.
+  template <typename T>
+  void setUniform(const std::string &name, const T &value) {
+    for (ShaderProgram *program : Programs) {
+      if (program && program->isUniform(name))
+        program->setUniform(program->getUniformSlot(name), value);
+    }
+  }
+
+private:
+  static const int STAGES = 6;
+  ShaderProgram *Programs[STAGES];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_PROGRAM_PIPELINE_HPP */
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// GPU Query Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglQuery.hpp"
+
+#include <stdexcept>
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////////////////// Query
+
+const int Query::LATENCY;
+
+Query::Query(const GLenum target)
+    : Target(target), Current(0), Active(false), Available(false),
+      Result(0) {
+  glGenQueries(LATENCY, Ids);
+  for (bool &pending : Pending)
+    pending = false;
+}
+
+Query::~Query() { glDeleteQueries(LATENCY, Ids); }
+
+// Queries complete in order, so the ring is read from the oldest one (the
+// next to be reused) and stops at the first result that is not ready yet.
+void Query::collect(const bool wait_for_oldest) {
+  for (int i = 0; i < LATENCY; i++) {
+    const int index = (Current + i) % LATENCY;
+    if (!Pending[index])
+      continue;
+    GLuint ready = GL_FALSE;
+    if (i == 0 && wait_for_oldest)
+      ready = GL_TRUE;
+    else
+      glGetQueryObjectuiv(Ids[index], GL_QUERY_RESULT_AVAILABLE, &ready);
+    if (!ready)
+      break;
+    glGetQueryObjectui64v(Ids[index], GL_QUERY_RESULT, &Result);
+    Pending[index] = false;
+    Available = true;
+  }
+}
+
+void Query::begin() {
+  if (Active)
+    throw std::runtime_error("Query already active.");
+  // Only blocks if the GPU is more than LATENCY queries behind.
+  collect(Pending[Current]);
+  glBeginQuery(Target, Ids[Current]);
+  Active = true;
+}
+
+void Query::end() {
+  if (!Active)
+    throw std::runtime_error("Query not active.");
+  glEndQuery(Target);
+  Pending[Current] = true;
+  Current = (Current + 1) % LATENCY;
+  Active = false;
+}
+
+GLuint64 Query::getResult() {
+  collect(false);
+  return Result;
+}
+
+bool Query::hasResult() {
+  collect(false);
+  return Available;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// GPU Query Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_QUERY_HPP
+#define MGL_QUERY_HPP
+
+#include <GL/glew.h>
+
+namespace mgl {
+
+class Query;
+
+////////////////////////////////////////////////////////////////////////// Query
+
+// A ring of query objects of one target (GL_FRAGMENT_SHADER_INVOCATIONS,
+// GL_TIME_ELAPSED, GL_SAMPLES_PASSED, ...). Results are collected a few
+// frames late so that reading them never stalls on the GPU.
+
+class Query final {
+public:
+  static const int LATENCY = 4;
+
+  explicit Query(const GLenum target);
+  ~Query();
+  Query(const Query &) = delete;
+  Query &operator=(const Query &) = delete;
+
+  void begin();
+  void end();
+
+  // Latest available result (0 until the first one arrives).
+  GLuint64 getResult();
+  bool hasResult();
+
+private:
+  GLenum Target;
+  GLuint Ids[LATENCY];
+  bool Pending[LATENCY];
+  int Current;
+  bool Active, Available;
+  GLuint64 Result;
+
+  void collect(const bool wait_for_oldest);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_QUERY_HPP */
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Render Queue Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglRenderQueue.hpp"
+
+#include <algorithm>
+
+namespace mgl {
+
+//////////////////////////////////////////////////////////////////// RenderQueue
+
+const unsigned int RenderQueue::PROGRAM_BITS;
+const unsigned int RenderQueue::MESH_BITS;
+const unsigned int RenderQueue::MATERIAL_BITS;
+const unsigned int RenderQueue::DEPTH_BITS;
+
+static uint64_t field(const uint64_t value, const unsigned int bits) {
+  return value & ((uint64_t(1) << bits) - 1);
+}
+
+uint64_t RenderQueue::makeKey(const Pass pass, const unsigned int program,
+                              const unsigned int mesh,
+                              const unsigned int material, const float depth) {
+  const uint64_t max_depth = (uint64_t(1) << DEPTH_BITS) - 1;
+  const uint64_t z =
+      uint64_t(std::min(std::max(depth, 0.0f), 1.0f) * float(max_depth));
+  const uint64_t state = (field(program, PROGRAM_BITS)
+                          << (MESH_BITS + MATERIAL_BITS)) |
+                         (field(mesh, MESH_BITS) << MATERIAL_BITS) |
+                         field(material, MATERIAL_BITS);
+  uint64_t key = uint64_t(pass) << 62;
+  if (pass == PASS_TRANSPARENT)
+    key |= ((max_depth - z) << (62 - DEPTH_BITS)) | state;
+  else
+    key |= (state << DEPTH_BITS) | z;
+  return key;
+}
+
+void RenderQueue::push(const uint64_t key, const unsigned int index) {
+  DrawItem item = {key, index};
+  Items.push_back(item);
+}
+
+// LSD radix sort, one byte per pass. Bytes that are equal in every key
+// (unused id bits, a single pass) are skipped.
+void RenderQueue::sort() {
+  const size_t n = Items.size();
+  Scratch.resize(n);
+  for (unsigned int shift = 0; shift < 64; shift += 8) {
+    size_t count[256] = {0};
+    for (size_t i = 0; i < n; i++)
+      count[(Items[i].key >> shift) & 0xff]++;
+    if (n == 0 || count[(Items[0].key >> shift) & 0xff] == n)
+      continue;
+    size_t offset = 0;
+    for (size_t &c : count) {
+      const size_t next = offset + c;
+      c = offset;
+      offset = next;
+    }
+    for (size_t i = 0; i < n; i++)
+      Scratch[count[(Items[i].key >> shift) & 0xff]++] = Items[i];
+    Items.swap(Scratch);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Render Queue Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_RENDER_QUEUE_HPP
+#define MGL_RENDER_QUEUE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mgl {
+
+class RenderQueue;
+
+//////////////////////////////////////////////////////////////////// RenderQueue
+
+// Draw items sorted by a 64-bit key so that submission only changes state
+// when the key changes. Opaque keys are pass|program|mesh|material|depth
+// (front-to-back within a state bucket); transparent keys put the inverted
+// depth right after the pass so they are drawn back-to-front.
+
+class RenderQueue final {
+public:
+  enum Pass { PASS_OPAQUE = 0, PASS_TRANSPARENT = 1 };
+
+  struct DrawItem {
+    uint64_t key;
+    unsigned int index;
+  };
+
+  static const unsigned int PROGRAM_BITS = 12;
+  static const unsigned int MESH_BITS = 12;
+  static const unsigned int MATERIAL_BITS = 14;
+  static const unsigned int DEPTH_BITS = 24;
+
+  // Depth is expected in [0,1]; ids wrap around past their bit width.
+  static uint64_t makeKey(const Pass pass, const unsigned int program,
+                          const unsigned int mesh, const unsigned int material,
+                          const float depth);
+
+  void push(const uint64_t key, const unsigned int index);
+  void sort();
+  void clear() { Items.clear(); }
+  size_t size() const { return Items.size(); }
+  const DrawItem &operator[](const size_t i) const { return Items[i]; }
+
+private:
+  std::vector<DrawItem> Items, Scratch;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_RENDER_QUEUE_HPP */
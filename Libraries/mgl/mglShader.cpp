@@ -8,17 +8,22 @@
 
 #include "./mglShader.hpp"
 
+#include <cstring>
 #include <fstream>
+#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <sstream>
-#include <vector>
+#include <stdexcept>
+
+#include "./mglStateCache.hpp"
 
 namespace mgl {
 
 ////////////////////////////////////////////////////////////////// ShaderProgram
 
+std::map<std::string, GLuint> ShaderProgram::ShaderCache;
+
 const std::string ShaderProgram::read(const std::string &filename) {
-  std::string line, shader_string;
   std::ifstream ifile(filename);
   if (!ifile.is_open()) {
     std::cerr << "[ERROR] Failed to open shader file: " << filename;
@@ -29,8 +34,91 @@ const std::string ShaderProgram::read(const std::string &filename) {
   return buffer.str();
 }
 
+static bool isDirective(const std::string &line, const char *directive) {
+  const size_t first = line.find_first_not_of(" \t");
+  return first != std::string::npos &&
+         line.compare(first, std::strlen(directive), directive) == 0;
+}
+
+void ShaderProgram::expand(const std::string &filename,
+                           std::set<std::string> &seen,
+                           std::vector<std::string> &files, std::string &out) {
+  if (!seen.insert(filename).second)
+    return; // already included
+  const size_t file_index = files.size();
+  files.push_back(filename);
+  const std::string dir = filename.substr(0, filename.find_last_of("/\\") + 1);
+
+  // #line <line> <source string>: keeps compiler messages pointing at the
+  // right file (source string N is files[N]).
+  if (file_index > 0)
+    out += "#line 1 " + std::to_string(file_index) + "\n";
+
+  std::istringstream source(read(filename));
+  std::string line;
+  int line_number = 0;
+  while (std::getline(source, line)) {
+    line_number++;
+    if (isDirective(line, "#include")) {
+      const size_t open = line.find('"');
+      const size_t close = line.find('"', open + 1);
+      if (open == std::string::npos || close == std::string::npos) {
+        std::cerr << "[" << filename << ":" << line_number
+                  << "] Malformed #include" << std::endl;
+        throw std::runtime_error("Failed to preprocess shader.");
+      }
+      expand(dir + line.substr(open + 1, close - open - 1), seen, files, out);
+      out += "#line " + std::to_string(line_number + 1) + " " +
+             std::to_string(file_index) + "\n";
+    } else if (file_index > 0 && isDirective(line, "#version")) {
+      out += "\n"; // only the including file may declare a version
+    } else {
+      out += line + "\n";
+    }
+  }
+}
+
+const std::string
+ShaderProgram::preprocess(const std::string &filename,
+                          const std::map<std::string, std::string> &defines,
+                          std::vector<std::string> &files) {
+  std::set<std::string> seen;
+  std::string code;
+  expand(filename, seen, files, code);
+  if (defines.empty())
+    return code;
+
+  std::string header;
+  for (auto &i : defines)
+    header += "#define " + i.first + " " + i.second + "\n";
+  // Defines must follow #version, which must come first in the source.
+  size_t at = 0;
+  std::istringstream source(code);
+  std::string line;
+  int line_number = 0;
+  while (std::getline(source, line)) {
+    line_number++;
+    at += line.size() + 1;
+    if (isDirective(line, "#version"))
+      break;
+  }
+  if (at >= code.size()) {
+    at = 0; // no #version
+    line_number = 0;
+  }
+  header += "#line " + std::to_string(line_number + 1) + " 0\n";
+  return code.insert(at, header);
+}
+
+void ShaderProgram::clearShaderCache() {
+  for (auto &i : ShaderCache)
+    glDeleteShader(i.second);
+  ShaderCache.clear();
+}
+
 void ShaderProgram::checkCompilation(const GLuint shader_id,
-                                     const std::string &filename) {
+                                     const std::string &filename,
+                                     const std::vector<std::string> &files) {
   GLint compiled;
   glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compiled);
   if (compiled == GL_FALSE) {
@@ -38,7 +126,11 @@ void ShaderProgram::checkCompilation(const GLuint shader_id,
     glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &length);
     std::vector<char> log(length);
     glGetShaderInfoLog(shader_id, length, &length, log.data());
-    std::cerr << "[" << filename << "] " << std::endl << log.data();
+    std::cerr << "[" << filename << "] " << std::endl;
+    for (size_t i = 1; i < files.size(); i++)
+      std::cerr << "  source " << i << ": " << files[i] << std::endl;
+    std::cerr << log.data();
+    glDeleteShader(shader_id);
     throw std::runtime_error("Failed to compile shader.");
   }
 }
@@ -59,23 +151,40 @@ void ShaderProgram::checkLinkage() {
 ShaderProgram::ShaderProgram() : ProgramId(glCreateProgram()) {}
 
 ShaderProgram::~ShaderProgram() {
-  glUseProgram(0);
+  StateCache::getInstance().useProgram(0);
   glDeleteProgram(ProgramId);
 }
 
 void ShaderProgram::addShader(const GLenum shader_type,
                               const std::string &filename) {
-  const GLuint shader_id = glCreateShader(shader_type);
-  const std::string scode = read(filename);
-  const GLchar *code = scode.c_str();
-  glShaderSource(shader_id, 1, &code, nullptr);
-  glCompileShader(shader_id);
-  checkCompilation(shader_id, filename);
+  std::vector<std::string> files;
+  const std::string scode = preprocess(filename, Defines, files);
+  const std::string key = std::to_string(shader_type) + "\n" + scode;
+
+  GLuint shader_id;
+  auto cached = ShaderCache.find(key);
+  if (cached != ShaderCache.end()) {
+    shader_id = cached->second;
+  } else {
+    shader_id = glCreateShader(shader_type);
+    const GLchar *code = scode.c_str();
+    glShaderSource(shader_id, 1, &code, nullptr);
+    glCompileShader(shader_id);
+    checkCompilation(shader_id, filename, files);
+    ShaderCache[key] = shader_id;
+  }
   glAttachShader(ProgramId, shader_id);
 
   Shaders[shader_type] = {shader_id};
 }
 
+void ShaderProgram::addDefine(const std::string &name,
+                              const std::string &value) {
+  Defines[name] = value;
+}
+
+void ShaderProgram::clearDefines() { Defines.clear(); }
+
 void ShaderProgram::addAttribute(const std::string &name, const GLuint index) {
   if (isAttribute(name)) {
     std::cerr << "[WARNING] Attribute " << name << " already exists"
@@ -116,15 +225,90 @@ bool ShaderProgram::isUniformBlock(const std::string &name) {
 void ShaderProgram::create() {
   glLinkProgram(ProgramId);
   checkLinkage();
+  // Shader objects stay alive in ShaderCache for other permutations.
   for (auto &i : Shaders) {
     glDetachShader(ProgramId, i.second);
-    glDeleteShader(i.second);
   }
+  resolveLocations();
+}
+
+void ShaderProgram::enableIntrospection() { Introspection = true; }
+
+void ShaderProgram::setSeparable() {
+  glProgramParameteri(ProgramId, GL_PROGRAM_SEPARABLE, GL_TRUE);
+}
 
+void ShaderProgram::addUniformEntry(const GLuint resource) {
+  const GLenum props[] = {GL_NAME_LENGTH, GL_LOCATION, GL_TYPE,
+                          GL_ARRAY_SIZE,  GL_BLOCK_INDEX, GL_OFFSET};
+  GLint values[6];
+  glGetProgramResourceiv(ProgramId, GL_UNIFORM, resource, 6, props, 6,
+                         nullptr, values);
+  std::vector<char> name(values[0]);
+  glGetProgramResourceName(ProgramId, GL_UNIFORM, resource, values[0],
+                           nullptr, name.data());
+  UniformTable.push_back({name.data(), values[1],
+                          static_cast<GLenum>(values[2]), values[3],
+                          values[4], values[4] < 0 ? -1 : values[5]});
+}
+
+void ShaderProgram::introspect() {
+  GLint count = 0, length = 0;
+  std::vector<char> name;
+
+  glGetProgramInterfaceiv(ProgramId, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES,
+                          &count);
+  glGetProgramInterfaceiv(ProgramId, GL_PROGRAM_INPUT, GL_MAX_NAME_LENGTH,
+                          &length);
+  name.resize(length + 1);
+  for (GLint i = 0; i < count; i++) {
+    const GLenum prop = GL_LOCATION;
+    GLint location;
+    glGetProgramResourceiv(ProgramId, GL_PROGRAM_INPUT, i, 1, &prop, 1,
+                           nullptr, &location);
+    glGetProgramResourceName(ProgramId, GL_PROGRAM_INPUT, i, length, nullptr,
+                             name.data());
+    if (location >= 0 && !isAttribute(name.data())) // skip gl_* built-ins
+      Attributes[name.data()] = {static_cast<GLuint>(location)};
+  }
+
+  glGetProgramInterfaceiv(ProgramId, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES,
+                          &count);
+  glGetProgramInterfaceiv(ProgramId, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH,
+                          &length);
+  name.resize(length + 1);
+  for (GLint i = 0; i < count; i++) {
+    const GLenum prop = GL_BUFFER_BINDING;
+    GLint binding;
+    glGetProgramResourceiv(ProgramId, GL_UNIFORM_BLOCK, i, 1, &prop, 1,
+                           nullptr, &binding);
+    glGetProgramResourceName(ProgramId, GL_UNIFORM_BLOCK, i, length, nullptr,
+                             name.data());
+    if (!isUniformBlock(name.data()))
+      Ubos[name.data()] = {static_cast<GLuint>(i),
+                           static_cast<GLuint>(binding)};
+  }
+
+  glGetProgramInterfaceiv(ProgramId, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+  for (GLint i = 0; i < count; i++) {
+    addUniformEntry(i);
+    const UniformEntry &entry = UniformTable.back();
+    if (entry.block < 0 && !isUniform(entry.name))
+      Uniforms[entry.name] = {entry.location};
+  }
+}
+
+void ShaderProgram::resolveLocations() {
+  UniformTable.clear();
+  if (Introspection)
+    introspect();
   for (auto &i : Uniforms) {
     i.second.index = glGetUniformLocation(ProgramId, i.first.c_str());
     if (i.second.index < 0)
       std::cerr << "WARNING: Uniform " << i.first << " not found." << std::endl;
+    else if (!Introspection)
+      addUniformEntry(
+          glGetProgramResourceIndex(ProgramId, GL_UNIFORM, i.first.c_str()));
   }
   for (auto &i : Ubos) {
     i.second.index = glGetUniformBlockIndex(ProgramId, i.first.c_str());
@@ -134,9 +318,117 @@ void ShaderProgram::create() {
   }
 }
 
-void ShaderProgram::bind() { glUseProgram(ProgramId); }
+void ShaderProgram::setBinaryRetrievable() {
+  glProgramParameteri(ProgramId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool ShaderProgram::loadBinary(const std::string &filename) {
+  std::ifstream ifile(filename, std::ios::binary);
+  if (!ifile.is_open())
+    return false;
+  GLenum format;
+  ifile.read(reinterpret_cast<char *>(&format), sizeof(format));
+  std::vector<char> binary((std::istreambuf_iterator<char>(ifile)),
+                           std::istreambuf_iterator<char>());
+  if (!ifile.eof() || binary.empty())
+    return false;
+
+  glProgramBinary(ProgramId, format, binary.data(),
+                  static_cast<GLsizei>(binary.size()));
+  GLint linked;
+  glGetProgramiv(ProgramId, GL_LINK_STATUS, &linked);
+  if (linked == GL_FALSE)
+    return false; // stale binary (driver or source changed)
+  resolveLocations();
+  return true;
+}
+
+void ShaderProgram::saveBinary(const std::string &filename) {
+  GLint length = 0;
+  glGetProgramiv(ProgramId, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+  std::vector<char> binary(length);
+  GLenum format;
+  glGetProgramBinary(ProgramId, length, &length, &format, binary.data());
+
+  std::ofstream ofile(filename, std::ios::binary);
+  if (!ofile.is_open()) {
+    std::cerr << "WARNING: Cannot write program binary " << filename
+              << std::endl;
+    return;
+  }
+  ofile.write(reinterpret_cast<const char *>(&format), sizeof(format));
+  ofile.write(binary.data(), length);
+}
+
+void ShaderProgram::bind() { StateCache::getInstance().useProgram(ProgramId); }
+
+void ShaderProgram::unbind() { StateCache::getInstance().useProgram(0); }
+
+GLint ShaderProgram::getUniformSlot(const std::string &name) const {
+  for (size_t i = 0; i < UniformTable.size(); i++) {
+    if (UniformTable[i].name == name)
+      return static_cast<GLint>(i);
+  }
+  if (MissingUniforms.insert(name).second)
+    std::cerr << "WARNING: Uniform " << name << " is not active in program "
+              << ProgramId << "." << std::endl;
+  return -1;
+}
+
+const ShaderProgram::UniformEntry *
+ShaderProgram::uniformEntry(const GLint slot, const GLenum type) {
+  if (slot < 0 || slot >= static_cast<GLint>(UniformTable.size()))
+    return nullptr;
+  const UniformEntry &entry = UniformTable[slot];
+#ifdef DEBUG
+  // GL_INT also sets bool and sampler uniforms.
+  if (type != GL_INT && entry.type != type)
+    std::cerr << "WARNING: Uniform " << entry.name << " set with wrong type."
+              << std::endl;
+#else
+  (void)type;
+#endif
+  return entry.location < 0 ? nullptr : &entry;
+}
 
-void ShaderProgram::unbind() { glUseProgram(0); }
+void ShaderProgram::setUniform(const GLint slot, const GLint value) {
+  if (const UniformEntry *entry = uniformEntry(slot, GL_INT))
+    glProgramUniform1i(ProgramId, entry->location, value);
+}
+
+void ShaderProgram::setUniform(const GLint slot, const GLfloat value) {
+  if (const UniformEntry *entry = uniformEntry(slot, GL_FLOAT))
+    glProgramUniform1f(ProgramId, entry->location, value);
+}
+
+void ShaderProgram::setUniform(const GLint slot, const glm::vec2 &value) {
+  if (const UniformEntry *entry = uniformEntry(slot, GL_FLOAT_VEC2))
+    glProgramUniform2fv(ProgramId, entry->location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(const GLint slot, const glm::vec3 &value) {
+  if (const UniformEntry *entry = uniformEntry(slot, GL_FLOAT_VEC3))
+    glProgramUniform3fv(ProgramId, entry->location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(const GLint slot, const glm::vec4 &value) {
+  if (const UniformEntry *entry = uniformEntry(slot, GL_FLOAT_VEC4))
+    glProgramUniform4fv(ProgramId, entry->location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(const GLint slot, const glm::mat3 &value) {
+  if (const UniformEntry *entry = uniformEntry(slot, GL_FLOAT_MAT3))
+    glProgramUniformMatrix3fv(ProgramId, entry->location, 1, GL_FALSE,
+                              glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(const GLint slot, const glm::mat4 &value) {
+  if (const UniformEntry *entry = uniformEntry(slot, GL_FLOAT_MAT4))
+    glProgramUniformMatrix4fv(ProgramId, entry->location, 1, GL_FALSE,
+                              glm::value_ptr(value));
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 } // namespace mgl
@@ -10,9 +10,12 @@
 #define MGL_SHADER_HPP
 
 #include <GL/glew.h>
+#include <glm/glm.hpp>
 
 #include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 namespace mgl {
 
@@ -45,6 +48,18 @@ public:
   };
   std::map<std::string, UboInfo> Ubos;
 
+  // Dense, typed table of active uniforms (GL 4.3 program interface query).
+  // Members of uniform blocks have no location but a block index and offset.
+  struct UniformEntry {
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint size;
+    GLint block;
+    GLint offset;
+  };
+  std::vector<UniformEntry> UniformTable;
+
   ShaderProgram();
   ~ShaderProgram();
 
@@ -54,20 +69,71 @@ public:
   ShaderProgram &operator=(ShaderProgram &&other) noexcept;
 
   void addShader(const GLenum shader_type, const std::string &filename);
+  void addDefine(const std::string &name, const std::string &value = "");
+  void clearDefines();
   void addAttribute(const std::string &name, const GLuint index);
   bool isAttribute(const std::string &name);
   void addUniform(const std::string &name);
   bool isUniform(const std::string &name);
   void addUniformBlock(const std::string &name, const GLuint binding_point);
   bool isUniformBlock(const std::string &name);
+  // Fill Uniforms, Attributes, Ubos and UniformTable from the linked program
+  // instead of relying on the addUniform/addAttribute/addUniformBlock lists.
+  void enableIntrospection();
+  // Must be called before create(): the program can then be bound to a
+  // subset of stages of a ProgramPipeline.
+  void setSeparable();
   void create();
+  // Program binaries (GL 4.1) for on-disk caching; loadBinary returns false
+  // if the file is missing or the driver rejects it.
+  void setBinaryRetrievable();
+  bool loadBinary(const std::string &filename);
+  void saveBinary(const std::string &filename);
   void bind();
   void unbind();
 
+  // Fast path: resolve a uniform once to a slot in UniformTable and set it
+  // by slot (glProgramUniform*, no bind needed). Unknown uniforms (slot -1)
+  // are ignored; type mismatches are reported in DEBUG builds.
+  GLint getUniformSlot(const std::string &name) const;
+  void setUniform(const GLint slot, const GLint value);
+  void setUniform(const GLint slot, const GLfloat value);
+  void setUniform(const GLint slot, const glm::vec2 &value);
+  void setUniform(const GLint slot, const glm::vec3 &value);
+  void setUniform(const GLint slot, const glm::vec4 &value);
+  void setUniform(const GLint slot, const glm::mat3 &value);
+  void setUniform(const GLint slot, const glm::mat4 &value);
+  template <typename T>
+  void setUniform(const std::string &name, const T &value) {
+    setUniform(getUniformSlot(name), value);
+  }
+
+  // Expands #include "file" (relative to the including file, each file at
+  // most once) and injects the given #defines right after #version.
+  static const std::string
+  preprocess(const std::string &filename,
+             const std::map<std::string, std::string> &defines,
+             std::vector<std::string> &files);
+  // Compiled shader objects are shared by every program that requests the
+  // same stage with the same preprocessed source (shader permutations).
+  static void clearShaderCache();
+
 private:
-  const std::string read(const std::string &filename);
-  void checkCompilation(const GLuint shader_id, const std::string &filename);
+  std::map<std::string, std::string> Defines;
+  bool Introspection = false;
+  mutable std::set<std::string> MissingUniforms;
+  static std::map<std::string, GLuint> ShaderCache;
+
+  static const std::string read(const std::string &filename);
+  static void expand(const std::string &filename, std::set<std::string> &seen,
+                     std::vector<std::string> &files, std::string &out);
+  void checkCompilation(const GLuint shader_id, const std::string &filename,
+                        const std::vector<std::string> &files);
   void checkLinkage();
+  void resolveLocations();
+  void introspect();
+  void addUniformEntry(const GLuint resource);
+  const UniformEntry *uniformEntry(const GLint slot, const GLenum type);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,251 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Shader Variants (Permutations) Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglShaderVariants.hpp"
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#define MGL_MKDIR(dir) _mkdir(dir)
+#else
+#include <sys/stat.h>
+#define MGL_MKDIR(dir) mkdir(dir, 0755)
+#endif
+
+namespace mgl {
+
+///////////////////////////////////////////////////////////////// ShaderVariants
+
+ShaderVariants::ShaderVariants() {}
+
+ShaderVariants::~ShaderVariants() {}
+
+void ShaderVariants::addShader(const GLenum shader_type,
+                               const std::string &filename) {
+  Stages.push_back({shader_type, filename});
+}
+
+void ShaderVariants::addFeature(const unsigned int feature,
+                                const std::string &define) {
+  Features[feature] = define;
+}
+
+void ShaderVariants::addAttribute(const std::string &name,
+                                  const GLuint index) {
+  Attributes[name] = index;
+}
+
+void ShaderVariants::addUniform(const std::string &name,
+                                const unsigned int features) {
+  Uniforms.push_back({name, features});
+}
+
+void ShaderVariants::addUniformBlock(const std::string &name,
+                                     const GLuint binding_point) {
+  Ubos[name] = binding_point;
+}
+
+void ShaderVariants::setCacheDirectory(const std::string &directory) {
+  CacheDirectory = directory;
+  if (!CacheDirectory.empty()) {
+    MGL_MKDIR(CacheDirectory.c_str()); // fails harmlessly if it exists
+  }
+}
+
+void ShaderVariants::enableIntrospection() { Introspection = true; }
+
+ShaderVariants::DefineMap
+ShaderVariants::defines(const unsigned int features) {
+  DefineMap result;
+  for (auto &i : Features) {
+    if (features & i.first)
+      result[i.second] = "1";
+  }
+  return result;
+}
+
+// Whether a conditional directive (#if, #ifdef, #ifndef, #elif) names the
+// define as a whole identifier; comments and other code do not count.
+static bool testsDefine(const std::string &source, const std::string &name) {
+  std::istringstream lines(source);
+  std::string line;
+  while (std::getline(lines, line)) {
+    size_t pos = line.find_first_not_of(" \t");
+    if (pos == std::string::npos || line[pos] != '#')
+      continue;
+    line = line.substr(0, line.find("//"));
+    pos = line.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string::npos)
+      continue;
+    size_t end = pos;
+    while (end < line.size() &&
+           std::isalpha(static_cast<unsigned char>(line[end])))
+      end++;
+    const std::string directive = line.substr(pos, end - pos);
+    if (directive != "if" && directive != "ifdef" && directive != "ifndef" &&
+        directive != "elif")
+      continue;
+    for (pos = end; pos < line.size();) {
+      const unsigned char c = static_cast<unsigned char>(line[pos]);
+      if (!std::isalpha(c) && c != '_') {
+        pos++;
+        continue;
+      }
+      end = pos;
+      while (end < line.size() &&
+             (std::isalnum(static_cast<unsigned char>(line[end])) ||
+              line[end] == '_'))
+        end++;
+      if (line.compare(pos, end - pos, name) == 0 && end - pos == name.size())
+        return true;
+      pos = end;
+    }
+  }
+  return false;
+}
+
+ShaderVariants::DefineMap
+ShaderVariants::stageDefines(const std::pair<GLenum, std::string> &stage,
+                             const unsigned int features) {
+  std::vector<std::string> files;
+  const std::string source =
+      ShaderProgram::preprocess(stage.second, DefineMap(), files);
+  DefineMap result;
+  for (auto &i : defines(features)) {
+    if (testsDefine(source, i.first))
+      result.insert(i);
+  }
+  return result;
+}
+
+// FNV-1a: stable across runs and compilers, unlike std::hash.
+static void fnv1a(uint64_t &hash, const std::string &data) {
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+}
+
+const std::string ShaderVariants::cacheFile(const StageList &stages,
+                                            const DefineMap &defs) {
+  uint64_t hash = 14695981039346656037ull;
+  for (auto &i : stages) {
+    std::vector<std::string> files;
+    fnv1a(hash, std::to_string(i.first));
+    fnv1a(hash, ShaderProgram::preprocess(i.second, defs, files));
+  }
+  // Binaries are only valid for the driver that produced them.
+  fnv1a(hash, reinterpret_cast<const char *>(glGetString(GL_RENDERER)));
+  fnv1a(hash, reinterpret_cast<const char *>(glGetString(GL_VERSION)));
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bin",
+                static_cast<unsigned long long>(hash));
+  return CacheDirectory + "/" + name;
+}
+
+std::unique_ptr<ShaderProgram>
+ShaderVariants::build(const StageList &stages, const DefineMap &defs,
+                      const unsigned int features, const bool separable) {
+  std::unique_ptr<ShaderProgram> program(new ShaderProgram());
+  // A stage program only has part of the uniforms: look them up instead.
+  if (Introspection || separable)
+    program->enableIntrospection();
+  if (separable)
+    program->setSeparable();
+  for (auto &i : Uniforms) {
+    if (!separable && (features & i.features) == i.features)
+      program->addUniform(i.name);
+  }
+  std::string source;
+  if (separable) {
+    std::vector<std::string> files;
+    source = ShaderProgram::preprocess(stages.front().second, defs, files);
+  }
+  for (auto &i : Ubos) {
+    if (!separable || source.find(i.first) != std::string::npos)
+      program->addUniformBlock(i.first, i.second);
+  }
+
+  std::string filename;
+  if (!CacheDirectory.empty()) {
+    filename = cacheFile(stages, defs);
+    if (program->loadBinary(filename)) {
+#ifdef DEBUG
+      std::cout << "Loaded shader variant " << features << " from " << filename
+                << std::endl;
+#endif
+      return program;
+    }
+  }
+
+  for (auto &i : defs) {
+    program->addDefine(i.first, i.second);
+  }
+  for (auto &i : stages) {
+    program->addShader(i.first, i.second);
+  }
+  for (auto &i : Attributes) {
+    program->addAttribute(i.first, i.second);
+  }
+  if (!filename.empty())
+    program->setBinaryRetrievable();
+  program->create();
+  if (!filename.empty())
+    program->saveBinary(filename);
+  return program;
+}
+
+ShaderProgram *ShaderVariants::get(const unsigned int features) {
+  std::unique_ptr<ShaderProgram> &program = Programs[features];
+  if (!program)
+    program = build(Stages, defines(features), features, false);
+  return program.get();
+}
+
+ProgramPipeline *ShaderVariants::getPipeline(const unsigned int features) {
+  return pipeline(Pipelines, features, false);
+}
+
+ProgramPipeline *
+ShaderVariants::getDepthPipeline(const unsigned int features) {
+  return pipeline(DepthPipelines, features, true);
+}
+
+ProgramPipeline *ShaderVariants::pipeline(
+    std::map<unsigned int, std::unique_ptr<ProgramPipeline>> &pipelines,
+    const unsigned int features, const bool depth_only) {
+  std::unique_ptr<ProgramPipeline> &pipeline = pipelines[features];
+  if (pipeline)
+    return pipeline.get();
+
+  pipeline.reset(new ProgramPipeline());
+  for (auto &stage : Stages) {
+    if (depth_only && stage.first == GL_FRAGMENT_SHADER)
+      continue;
+    const DefineMap defs = stageDefines(stage, features);
+    std::string key = std::to_string(stage.first) + " " + stage.second;
+    for (auto &i : defs)
+      key += " " + i.first;
+
+    std::unique_ptr<ShaderProgram> &program = StagePrograms[key];
+    if (!program)
+      program = build(StageList(1, stage), defs, features, true);
+    pipeline->useProgramStages(ProgramPipeline::stageBit(stage.first),
+                               program.get());
+  }
+  return pipeline.get();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
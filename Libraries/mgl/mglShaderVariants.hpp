@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Shader Variants (Permutations) Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_SHADER_VARIANTS_HPP
+#define MGL_SHADER_VARIANTS_HPP
+
+#include <GL/glew.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./mglProgramPipeline.hpp"
+#include "./mglShader.hpp"
+
+namespace mgl {
+
+class ShaderVariants;
+
+///////////////////////////////////////////////////////////////// ShaderVariants
+
+// One uber-source specialised by a bitmask of features, each feature mapping
+// to a #define. Variants are linked on first use, kept in memory and, if a
+// cache directory is set, stored as program binaries on disk. Pipelines
+// link every stage as a separable program that only sees the #defines it
+// mentions, so stages that do not depend on a feature are shared.
+
+class ShaderVariants final {
+public:
+  ShaderVariants();
+  ~ShaderVariants();
+
+  ShaderVariants(const ShaderVariants &) = delete;
+  ShaderVariants &operator=(const ShaderVariants &) = delete;
+
+  void addShader(const GLenum shader_type, const std::string &filename);
+  void addFeature(const unsigned int feature, const std::string &define);
+  void addAttribute(const std::string &name, const GLuint index);
+  // The uniform is only looked up in variants having all of `features`.
+  void addUniform(const std::string &name, const unsigned int features = 0);
+  void addUniformBlock(const std::string &name, const GLuint binding_point);
+  void setCacheDirectory(const std::string &directory);
+  void enableIntrospection();
+
+  ShaderProgram *get(const unsigned int features);
+  ProgramPipeline *getPipeline(const unsigned int features);
+  // Same stage programs as getPipeline() minus the fragment stage, for depth
+  // only passes: positions are computed by the very same vertex program.
+  ProgramPipeline *getDepthPipeline(const unsigned int features);
+  size_t getVariantCount() const { return Programs.size() + Pipelines.size(); }
+  size_t getStageProgramCount() const { return StagePrograms.size(); }
+
+private:
+  struct UniformInfo {
+    std::string name;
+    unsigned int features;
+  };
+  typedef std::vector<std::pair<GLenum, std::string>> StageList;
+  typedef std::map<std::string, std::string> DefineMap;
+
+  StageList Stages;
+  std::map<unsigned int, std::string> Features;
+  std::map<std::string, GLuint> Attributes;
+  std::vector<UniformInfo> Uniforms;
+  std::map<std::string, GLuint> Ubos;
+  std::string CacheDirectory;
+  bool Introspection = false;
+  std::map<unsigned int, std::unique_ptr<ShaderProgram>> Programs;
+  std::map<std::string, std::unique_ptr<ShaderProgram>> StagePrograms;
+  std::map<unsigned int, std::unique_ptr<ProgramPipeline>> Pipelines;
+  std::map<unsigned int, std::unique_ptr<ProgramPipeline>> DepthPipelines;
+
+  DefineMap defines(const unsigned int features);
+  DefineMap stageDefines(const std::pair<GLenum, std::string> &stage,
+                         const unsigned int features);
+  const std::string cacheFile(const StageList &stages, const DefineMap &defs);
+  ProgramPipeline *
+  pipeline(std::map<unsigned int, std::unique_ptr<ProgramPipeline>> &pipelines,
+           const unsigned int features, const bool depth_only);
+  std::unique_ptr<ShaderProgram> build(const StageList &stages,
+                                       const DefineMap &defs,
+                                       const unsigned int features,
+                                       const bool separable);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_SHADER_VARIANTS_HPP */
@@ -0,0 +1,150 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL State Cache Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglStateCache.hpp"
+
+namespace mgl {
+
+///////////////////////////////////////////////////////////////////// StateCache
+
+const GLuint StateCache::UNKNOWN;
+
+
+StateCache::StateCache()
+    : Issued(0), Filtered(0), FrameIssued(0), FrameFiltered(0) {
+  invalidate();
+}
+
+StateCache &StateCache::getInstance() {
+  static StateCache instance;
+  return instance;
+}
+
+bool StateCache::changed(GLuint &current, const GLuint value) {
+  if (current == value) {
+    Filtered++;
+    return false;
+  }
+  current = value;
+  Issued++;
+  return true;
+}
+
+void StateCache::useProgram(const GLuint program) {
+  if (changed(Program, program))
+    glUseProgram(program);
+}
+
+void StateCache::bindProgramPipeline(const GLuint pipeline) {
+  if (changed(Pipeline, pipeline))
+    glBindProgramPipeline(pipeline);
+}
+
+// The element array binding belongs to the vertex array object.
+void StateCache::bindVertexArray(const GLuint vao) {
+  if (changed(Vao, vao)) {
+    glBindVertexArray(vao);
+    Buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+  }
+}
+
+void StateCache::bindBuffer(const GLenum target, const GLuint buffer) {
+  auto i = Buffers.insert(std::make_pair(target, UNKNOWN)).first;
+  if (changed(i->second, buffer))
+    glBindBuffer(target, buffer);
+}
+
+void StateCache::activeTexture(const GLuint unit) {
+  if (changed(ActiveUnit, unit))
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void StateCache::bindTexture(const GLuint unit, const GLenum target,
+                             const GLuint texture) {
+  const std::pair<GLuint, GLenum> key(unit, target);
+  auto i = Textures.insert(std::make_pair(key, UNKNOWN)).first;
+  if (i->second == texture) {
+    Filtered++;
+    return;
+  }
+  activeTexture(unit);
+  changed(i->second, texture);
+  glBindTexture(target, texture);
+}
+
+void StateCache::setEnabled(const GLenum capability, const bool enabled) {
+  auto i = Capabilities.find(capability);
+  if (i != Capabilities.end() && i->second == enabled) {
+    Filtered++;
+    return;
+  }
+  Capabilities[capability] = enabled;
+  Issued++;
+  if (enabled)
+    glEnable(capability);
+  else
+    glDisable(capability);
+}
+
+void StateCache::blendFunc(const GLenum sfactor, const GLenum dfactor) {
+  if (BlendSrc == sfactor && BlendDst == dfactor) {
+    Filtered++;
+    return;
+  }
+  BlendSrc = sfactor;
+  BlendDst = dfactor;
+  Issued++;
+  glBlendFunc(sfactor, dfactor);
+}
+
+void StateCache::depthMask(const GLboolean flag) {
+  if (changed(DepthWrite, flag))
+    glDepthMask(flag);
+}
+
+// The four channel flags are packed into one value (red in bit 0).
+void StateCache::colorMask(const GLboolean red, const GLboolean green,
+                           const GLboolean blue, const GLboolean alpha) {
+  const GLuint mask = (red ? 1u : 0u) | (green ? 2u : 0u) |
+                      (blue ? 4u : 0u) | (alpha ? 8u : 0u);
+  if (changed(ColorWrite, mask))
+    glColorMask(red, green, blue, alpha);
+}
+
+void StateCache::depthFunc(const GLenum func) {
+  if (changed(DepthFunc, func))
+    glDepthFunc(func);
+}
+
+void StateCache::cullFace(const GLenum mode) {
+  if (changed(CullMode, mode))
+    glCullFace(mode);
+}
+
+// Forgets everything: the next call of each kind reaches OpenGL.
+void StateCache::invalidate() {
+  Program = Pipeline = Vao = ActiveUnit = UNKNOWN;
+  BlendSrc = BlendDst = DepthWrite = ColorWrite = DepthFunc = CullMode =
+      UNKNOWN;
+  Buffers.clear();
+  Textures.clear();
+  Capabilities.clear();
+}
+
+void StateCache::endFrame() {
+  FrameIssued = Issued;
+  FrameFiltered = Filtered;
+  Issued = Filtered = 0;
+}
+
+unsigned int StateCache::getIssuedCalls() const { return FrameIssued; }
+
+unsigned int StateCache::getFilteredCalls() const { return FrameFiltered; }
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
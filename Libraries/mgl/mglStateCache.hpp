@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// OpenGL State Cache Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_STATE_CACHE_HPP
+#define MGL_STATE_CACHE_HPP
+
+#include <GL/glew.h>
+
+#include <map>
+#include <utility>
+
+namespace mgl {
+
+class StateCache;
+
+///////////////////////////////////////////////////////////////////// StateCache
+
+// Shadows the bound objects and fixed-function state of the current context
+// and only forwards calls that change it. Anything that calls OpenGL directly
+// must invalidate() the cache afterwards.
+
+class StateCache {
+public:
+  static StateCache &getInstance();
+
+  void useProgram(const GLuint program);
+  void bindProgramPipeline(const GLuint pipeline);
+  void bindVertexArray(const GLuint vao);
+  void bindBuffer(const GLenum target, const GLuint buffer);
+  void activeTexture(const GLuint unit);
+  void bindTexture(const GLuint unit, const GLenum target,
+                   const GLuint texture);
+
+  void setEnabled(const GLenum capability, const bool enabled);
+  void blendFunc(const GLenum sfactor, const GLenum dfactor);
+  void depthMask(const GLboolean flag);
+  void colorMask(const GLboolean red, const GLboolean green,
+                 const GLboolean blue, const GLboolean alpha);
+  void depthFunc(const GLenum func);
+  void cullFace(const GLenum mode);
+
+  void invalidate();
+  void endFrame();
+
+  // Counters of the last completed frame.
+  unsigned int getIssuedCalls() const;
+  unsigned int getFilteredCalls() const;
+
+private:
+  StateCache();
+
+  static const GLuint UNKNOWN = ~0u;
+
+  GLuint Program, Pipeline, Vao, ActiveUnit;
+  GLuint BlendSrc, BlendDst, DepthWrite, ColorWrite, DepthFunc, CullMode;
+  std::map<GLenum, GLuint> Buffers;
+  std::map<std::pair<GLuint, GLenum>, GLuint> Textures;
+  std::map<GLenum, bool> Capabilities;
+
+  unsigned int Issued, Filtered;
+  unsigned int FrameIssued, FrameFiltered;
+
+  bool changed(GLuint &current, const GLuint value);
+
+public:
+  StateCache(StateCache const &) = delete;
+  void operator=(StateCache const &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_STATE_CACHE_HPP */
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Transform Hierarchy Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglTransformHierarchy.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace mgl {
+
+///////////////////////////////////////////////////////////// TransformHierarchy
+
+const int TransformHierarchy::NO_PARENT;
+
+int TransformHierarchy::add(const glm::mat4 &local, const int parent) {
+  if (parent != NO_PARENT && (parent < 0 || parent >= int(size())))
+    throw std::runtime_error("Transform parent must be added before child.");
+  Parents.push_back(parent);
+  Local.push_back(local);
+  World.push_back(local);
+  Dirty.push_back(1);
+  return int(size()) - 1;
+}
+
+void TransformHierarchy::reset(const int node, const glm::mat4 &local,
+                               const int parent) {
+  if (parent != NO_PARENT && (parent < 0 || parent >= node))
+    throw std::runtime_error("Transform parent must be added before child.");
+  Parents[node] = parent;
+  Local[node] = local;
+  World[node] = local;
+  Dirty[node] = 1;
+}
+
+void TransformHierarchy::setLocal(const int node, const glm::mat4 &local) {
+  Local[node] = local;
+  Dirty[node] = 1;
+}
+
+void TransformHierarchy::clear() {
+  Parents.clear();
+  Local.clear();
+  World.clear();
+  Dirty.clear();
+}
+
+// Parents precede children, so a node's dirty flag is final (own change or
+// inherited from its parent) by the time the loop reaches it.
+size_t TransformHierarchy::update() {
+  size_t updated = 0;
+  const size_t n = size();
+  for (size_t i = 0; i < n; i++) {
+    const int parent = Parents[i];
+    if (parent != NO_PARENT)
+      Dirty[i] |= Dirty[parent];
+    if (Dirty[i]) {
+      World[i] = parent == NO_PARENT ? Local[i] : World[parent] * Local[i];
+      updated++;
+    }
+  }
+  std::fill(Dirty.begin(), Dirty.end(), 0);
+  return updated;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Transform Hierarchy Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_TRANSFORM_HIERARCHY_HPP
+#define MGL_TRANSFORM_HIERARCHY_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mgl {
+
+class TransformHierarchy;
+
+///////////////////////////////////////////////////////////// TransformHierarchy
+
+// Local and world matrices of a node tree kept in contiguous arrays, in
+// topological order (a parent is always added before its children). Only
+// nodes whose local matrix or an ancestor's changed are recomputed, in a
+// single linear pass.
+
+class TransformHierarchy final {
+public:
+  static const int NO_PARENT = -1;
+
+  int add(const glm::mat4 &local, const int parent = NO_PARENT);
+  // Reuses an existing slot; the parent must still come before it.
+  void reset(const int node, const glm::mat4 &local,
+             const int parent = NO_PARENT);
+  void setLocal(const int node, const glm::mat4 &local);
+  const glm::mat4 &getLocal(const int node) const { return Local[node]; }
+  const glm::mat4 &getWorld(const int node) const { return World[node]; }
+  int getParent(const int node) const { return Parents[node]; }
+  size_t size() const { return Parents.size(); }
+  void clear();
+
+  // Returns the number of world matrices recomputed.
+  size_t update();
+
+private:
+  std::vector<int> Parents;
+  std::vector<glm::mat4> Local;
+  std::vector<glm::mat4> World;
+  std::vector<unsigned char> Dirty;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_TRANSFORM_HIERARCHY_HPP */
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Triple Buffer Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_TRIPLE_BUFFER_HPP
+#define MGL_TRIPLE_BUFFER_HPP
+
+#include <atomic>
+
+namespace mgl {
+
+template <typename T> class TripleBuffer;
+
+/////////////////////////////////////////////////////////////////// TripleBuffer
+
+// Lock-free handoff of the latest value from one producer thread to one
+// consumer thread. Each side owns one buffer and the third is shared: the
+// producer publishes by swapping its buffer with the shared one, and the
+// consumer fetches by swapping back only when something new was published.
+// Neither side ever waits; unread values are overwritten by newer ones.
+
+template <typename T> class TripleBuffer final {
+public:
+  TripleBuffer() : Write(0), Read(2), Shared(1) {}
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+  // Producer side: fill the write buffer, then publish it.
+  T &getWriteBuffer() { return Buffers[Write]; }
+  void publish() { Write = Shared.exchange(Write | DIRTY) & INDEX; }
+
+  // Consumer side: true if a newer value was published since the last fetch.
+  bool fetch() {
+    if (!(Shared.load(std::memory_order_relaxed) & DIRTY))
+      return false;
+    Read = Shared.exchange(Read) & INDEX;
+    return true;
+  }
+  const T &getReadBuffer() const { return Buffers[Read]; }
+
+private:
+  static const unsigned INDEX = 3, DIRTY = 4;
+  T Buffers[3];
+  unsigned Write, Read;
+  std::atomic<unsigned> Shared; // index of the shared buffer | DIRTY
+};
+
+template <typename T> const unsigned TripleBuffer<T>::INDEX;
+template <typename T> const unsigned TripleBuffer<T>::DIRTY;
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_TRIPLE_BUFFER_HPP */
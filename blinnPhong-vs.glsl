@@ -18,10 +18,7 @@ out vec2 exTexcoord; // Coordenadas de textura interpoladas
 uniform mat4 ModelMatrix;
 
 // Uniform Buffer Object da camara (Contem as matrizes de view e projection)
-uniform Camera {
-    mat4 ViewMatrix;
-    mat4 ProjectionMatrix;
-};
+#include "camera.glsl"
 
 
 void main(void)
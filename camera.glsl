@@ -0,0 +1,5 @@
+// Bloco uniforme da camara (mgl::CAMERA_BLOCK), partilhado por todos os programas
+layout(std140) uniform Camera {
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+};
@@ -23,10 +23,7 @@ out float gLife;
 uniform float time;
 
 // Bloco de camera (view e projection)
-layout(std140) uniform Camera {
-    mat4 ViewMatrix;
-    mat4 ProjectionMatrix;
-};
+#include "camera.glsl"
 
 // Funcao simples de hash para gerar aleatoriedade
 float hash(float n) {
@@ -0,0 +1,101 @@
+#version 430 core
+
+// Testa caixas em world space contra a piramide Hi-Z: a caixa esta oculta se
+// a sua profundidade mais proxima for maior que a mais distante dos texels
+// que cobre, num nivel em que cobre no maximo 2x2 texels.
+// A lista de desenho sai daqui: o instanceCount dos comandos indirectos de
+// cada caixa fica a 1 ou a 0, sem o CPU ler nada a meio do frame.
+//   phase 0: caixas no frustum visiveis no ultimo teste (previous)
+//   phase 1: testa todas as caixas, grava o resultado (visible) e seleciona
+//            as caixas no frustum que passaram a ser visiveis
+
+layout(local_size_x = 64) in;
+
+struct Box {
+    vec4 minimum;
+    vec4 maximum;
+    uint firstCommand;
+    uint commandCount;
+    uint inFrustum;
+    uint padding;
+};
+
+layout(std430, binding = 0) readonly buffer Boxes {
+    Box boxes[];
+};
+
+layout(std430, binding = 1) readonly buffer Previous {
+    uint previousHidden;
+    uint previous[];
+};
+
+// hidden: caixas com comandos no frustum que o teste escondeu (estatistica)
+layout(std430, binding = 2) buffer Visibility {
+    uint hidden;
+    uint visible[];
+};
+
+// DrawElementsIndirectCommand: count, instanceCount, firstIndex, baseVertex, baseInstance
+layout(std430, binding = 3) writeonly buffer Commands {
+    uint commands[];
+};
+
+layout(binding = 0) uniform sampler2D pyramid;
+uniform mat4 viewProjection;
+uniform int boxCount;
+uniform int phase;
+uniform int hasPrevious; // sem historico todas as caixas contam como visiveis
+
+bool testBox(uint i) {
+    vec3 bmin = boxes[i].minimum.xyz;
+    vec3 bmax = boxes[i].maximum.xyz;
+    vec2 uvMin = vec2(1.0);
+    vec2 uvMax = vec2(0.0);
+    float depth = 1.0;
+    for (int c = 0; c < 8; c++) {
+        vec3 corner = mix(bmin, bmax, vec3(c & 1, (c >> 1) & 1, (c >> 2) & 1));
+        vec4 clip = viewProjection * vec4(corner, 1.0);
+        // caixa a atravessar o near plane: considerada visivel
+        if (clip.w <= 0.0) return true;
+        vec3 ndc = clip.xyz / clip.w;
+        uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+        uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+        depth = min(depth, ndc.z * 0.5 + 0.5);
+    }
+    uvMin = clamp(uvMin, 0.0, 1.0);
+    uvMax = clamp(uvMax, 0.0, 1.0);
+
+    vec2 size = (uvMax - uvMin) * vec2(textureSize(pyramid, 0));
+    float level = ceil(log2(max(max(size.x, size.y), 1.0)));
+    level = min(level, float(textureQueryLevels(pyramid) - 1));
+
+    float occluder = max(max(textureLod(pyramid, uvMin, level).r,
+                             textureLod(pyramid, vec2(uvMax.x, uvMin.y), level).r),
+                         max(textureLod(pyramid, vec2(uvMin.x, uvMax.y), level).r,
+                             textureLod(pyramid, uvMax, level).r));
+    return depth <= occluder;
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(boxCount)) return;
+
+    bool wasVisible = hasPrevious == 0 || previous[i] != 0u;
+    bool selected;
+    if (phase == 0) {
+        selected = wasVisible;
+    } else {
+        bool isVisible = testBox(i);
+        visible[i] = isVisible ? 1u : 0u;
+        selected = isVisible && !wasVisible;
+        if (!isVisible && boxes[i].inFrustum != 0u && boxes[i].commandCount > 0u) {
+            atomicAdd(hidden, 1u);
+        }
+    }
+
+    uint instances = selected && boxes[i].inFrustum != 0u ? 1u : 0u;
+    uint first = boxes[i].firstCommand;
+    for (uint c = first; c < first + boxes[i].commandCount; c++) {
+        commands[5u * c + 1u] = instances;
+    }
+}
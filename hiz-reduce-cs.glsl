@@ -0,0 +1,34 @@
+#version 430 core
+
+// Constroi um nivel da piramide Hi-Z: cada texel guarda a profundidade maxima
+// (mais distante) dos texels que cobre no nivel anterior. O nivel 0 e uma
+// copia do depth buffer (mesmo tamanho).
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D source;
+uniform int sourceLevel;
+
+layout(r32f, binding = 0) writeonly uniform image2D destination;
+
+void main() {
+    ivec2 size = imageSize(destination);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, size))) return;
+
+    // 1x1 na copia, 2x2 nos restantes (3 na ultima linha/coluna de tamanhos impares)
+    ivec2 sourceSize = textureSize(source, sourceLevel);
+    ivec2 scale = ivec2(greaterThan(sourceSize, size)) + 1;
+    ivec2 first = texel * scale;
+    ivec2 last = first + scale - 1;
+    if (texel.x == size.x - 1) last.x = sourceSize.x - 1;
+    if (texel.y == size.y - 1) last.y = sourceSize.y - 1;
+
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; y++) {
+        for (int x = first.x; x <= last.x; x++) {
+            depth = max(depth, texelFetch(source, ivec2(x, y), sourceLevel).r);
+        }
+    }
+    imageStore(destination, texel, vec4(depth));
+}
@@ -0,0 +1,51 @@
+// ==================== NOISE LIBRARY ====================
+// Value noise partilhado pelos shaders procedurais (#include "noise.glsl")
+
+// Hash inteiro (sem sin): devolve um valor entre 0 e 1 para cada celula
+// inteira. Mais barato que fract(sin(...)) e estavel para coordenadas grandes.
+float hash(vec3 p) {
+    uvec3 v = uvec3(ivec3(floor(p))) * 1664525u + 1013904223u;
+    v.x += v.y * v.z;
+    v.y += v.z * v.x;
+    v.z += v.x * v.y;
+    v ^= v >> 16u;
+    v.x += v.y * v.z;
+    return float(v.x) * (1.0 / 4294967296.0);
+}
+
+// Noise 3D suave (value noise com interpolacao trilinear)
+float noise(vec3 p) {
+    vec3 i = floor(p);   // celula inteira
+    vec3 f = fract(p);   // posicao dentro da celula (0 a 1)
+
+    // Suavizacao cubica (evita transicoes)
+    f = f * f * (3.0 - 2.0 * f);
+
+    float n000 = hash(i + vec3(0,0,0));
+    float n100 = hash(i + vec3(1,0,0));
+    float n010 = hash(i + vec3(0,1,0));
+    float n110 = hash(i + vec3(1,1,0));
+    float n001 = hash(i + vec3(0,0,1));
+    float n101 = hash(i + vec3(1,0,1));
+    float n011 = hash(i + vec3(0,1,1));
+    float n111 = hash(i + vec3(1,1,1));
+
+    return mix(
+        mix(mix(n000, n100, f.x), mix(n010, n110, f.x), f.y),
+        mix(mix(n001, n101, f.x), mix(n011, n111, f.x), f.y),
+        f.z
+    );
+}
+
+// Variante 2D: interpola apenas em XY (metade dos hashes, usada nas brasas)
+float noiseXY(vec3 p) {
+    vec3 i = floor(p);
+    vec3 f = fract(p);
+    f = f * f * (3.0 - 2.0 * f);
+
+    return mix(
+        mix(hash(i), hash(i + vec3(1,0,0)), f.x),
+        mix(hash(i + vec3(0,1,0)), hash(i + vec3(1,1,0)), f.x),
+        f.y
+    );
+}
@@ -0,0 +1,14 @@
+#version 430 core
+
+in vec2 exTexcoord;
+in vec4 exColor;
+
+out vec4 FragColor;
+
+// Atlas da fonte (R8): 1 nos pixeis das letras e no texel usado pelos quads
+layout(binding = 0) uniform sampler2D atlas;
+
+void main()
+{
+    FragColor = vec4(exColor.rgb, exColor.a * texture(atlas, exTexcoord).r);
+}
@@ -0,0 +1,20 @@
+#version 430 core
+
+// Quads do overlay em pixeis da janela, com a origem no canto superior esquerdo
+
+layout (location = 0) in vec2 inPosition;
+layout (location = 1) in vec2 inTexcoord;
+layout (location = 2) in vec4 inColor;
+
+out vec2 exTexcoord;
+out vec4 exColor;
+
+uniform vec2 screenSize;
+
+void main()
+{
+    vec2 ndc = inPosition / screenSize * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+    exTexcoord = inTexcoord;
+    exColor = inColor;
+}
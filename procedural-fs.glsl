@@ -0,0 +1,180 @@
+#version 410 core
+
+// Uber shader dos materiais procedurais (mgl::ShaderVariants).
+// Cada variante e compilada com um subconjunto destes defines:
+//   ASH      - cinza no centro da fogueira
+//   STONES   - pedras queimadas
+//   TERRAIN  - terreno com queda de intensidade do fogo
+//   EMBERS   - brasas com pulsacao emissiva
+//   TEXTURED - multiplica a cor base por albedoMap
+//   LIT      - iluminacao Blinn-Phong (sem LIT a cor base e usada directamente)
+//   INSTANCED - material por instancia (vem do vertex shader)
+
+layout (location = 0) in vec3 exPosition;
+layout (location = 1) in vec3 exNormal;
+#ifdef TEXTURED
+layout (location = 2) in vec2 exTexcoord;
+#endif
+
+layout (location = 0) out vec4 FragColor;
+
+// ----------------- Iluminacao -----------------
+
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+uniform vec3 viewPos;
+
+// ----------------- Material -----------------
+
+#ifdef INSTANCED
+// ambientStrength, specularStrength, shininess
+layout (location = 3) flat in vec3 exMaterial;
+#else
+uniform float ambientStrength;
+uniform float specularStrength;
+uniform float shininess;
+#endif
+
+#ifdef TEXTURED
+uniform sampler2D albedoMap;
+#endif
+
+#ifdef TERRAIN
+// Raio de influencia termica e cor quente da fogueira
+uniform float fireRadius;
+uniform vec3 fireColor;
+#endif
+
+#ifdef EMBERS
+uniform float time;
+#endif
+
+#include "noise.glsl"
+
+// ----------------- Materiais Procedurais -----------------
+
+#ifdef ASH
+vec3 proceduralAsh(vec3 pos) {
+    vec3 p = pos * 2.0;
+
+    // Volumes grandes de cinza + grao fino (po / areia)
+    float base  = pow(noise(p * 0.6), 1.4);
+    float grain = pow(noise(p * 30.0), 2.5);
+
+    float ash = mix(base, grain, 0.65) * 0.85;
+
+    vec3 darkAsh  = vec3(0.05, 0.05, 0.06);
+    vec3 midAsh   = vec3(0.65, 0.65, 0.67);
+    vec3 lightAsh = vec3(0.92, 0.92, 0.92);
+
+    vec3 color = mix(darkAsh, midAsh, ash);
+    return mix(color, lightAsh, smoothstep(0.65, 1.0, ash));
+}
+#endif
+
+#ifdef STONES
+vec3 proceduralCharredStone(vec3 pos) {
+    vec3 p = pos * 200.0;
+
+    // Estrutura base + rugosidade fina (os veios tinham peso 0.0)
+    float base  = pow(noise(p * 0.8), 1.3);
+    float grain = pow(noise(p * 10.0), 3.0);
+
+    float stone = mix(base, grain, 0.2);
+
+    vec3 deepBlack = vec3(0.03, 0.03, 0.03);
+    vec3 charcoal  = vec3(0.12, 0.12, 0.12);
+    vec3 ashGray   = vec3(0.35, 0.35, 0.35);
+
+    vec3 color = mix(deepBlack, charcoal, stone);
+    return mix(color, ashGray, smoothstep(0.7, 1.0, stone));
+}
+#endif
+
+#ifdef TERRAIN
+vec3 proceduralCharredGround(vec3 pos) {
+    float stone = pow(noise(pos * 2.0 * 8.8), 1.3);
+
+    vec3 deepBlack = vec3(0.03, 0.03, 0.03);
+    vec3 charcoal  = vec3(0.12, 0.12, 0.12);
+    vec3 ashGray   = vec3(0.35, 0.35, 0.35);
+
+    vec3 color = mix(deepBlack, charcoal, stone);
+    return mix(color, ashGray, smoothstep(0.7, 1.0, stone));
+}
+#endif
+
+// ----------------- Main -----------------
+
+void main()
+{
+    vec3 baseColor = vec3(1.0);
+    vec3 emissive = vec3(0.0);
+    float lightScale = 1.0;
+
+#if defined(ASH)
+    // Calor da fogueira: 1.0 no centro, 0.0 fora
+    vec3 fireCenter = vec3(0.0, -0.3, 0.0);
+    float distToFire = distance(exPosition.xz, fireCenter.xz);
+    float heat = pow(1.0 - smoothstep(0.0, 0.9, distToFire), 1.5);
+
+    vec3 fireTint = vec3(1.0, 0.35, 0.15);
+    baseColor = mix(proceduralAsh(exPosition), fireTint, heat * 6.0);
+
+#elif defined(STONES)
+    baseColor = proceduralCharredStone(exPosition);
+
+#elif defined(TERRAIN)
+    // Factor de influencia termica (1 perto, 0 longe)
+    float distToFire = distance(exPosition, lightPos) / 1.5;
+    float fireInfluence = 1.4 - smoothstep(0.0, fireRadius, distToFire);
+    lightScale = fireInfluence;
+
+    vec3 emberTint = fireColor * fireInfluence;
+    baseColor = mix(proceduralCharredGround(exPosition), emberTint, fireInfluence);
+
+#elif defined(EMBERS)
+    // Mascara de fissuras incandescentes
+    float cracks = noiseXY(exPosition * 8.0);
+    float grain  = noiseXY(exPosition * 25.0);
+    float mask = smoothstep(0.5, 0.8, cracks) * grain;
+
+    vec3 coalColor  = vec3(0.03, 0.03, 0.03);
+    vec3 emberColor = vec3(1.0, 0.35, 0.08);
+    baseColor = mix(coalColor, emberColor, mask);
+
+    // Emissao com pulsacao lenta (nao depende da luz)
+    float slowPulse = 0.4 + 0.4 * sin(time + exPosition.x * 3.0);
+    emissive = emberColor * mask * 3.0 * slowPulse;
+#endif
+
+#ifdef TEXTURED
+    baseColor *= texture(albedoMap, exTexcoord).rgb;
+#endif
+
+#ifdef LIT
+#ifdef INSTANCED
+    float ambientStrength = exMaterial.x;
+    float specularStrength = exMaterial.y;
+    float shininess = exMaterial.z;
+#endif
+    vec3 N = normalize(exNormal);
+    vec3 L = normalize(lightPos - exPosition);
+    vec3 V = normalize(viewPos - exPosition);
+    vec3 H = normalize(L + V);
+
+    vec3 ambient = ambientStrength * lightColor;
+
+    float diff = max(dot(N, L), 0.0);
+    vec3 diffuse = diff * lightColor;
+
+    float spec = pow(max(dot(N, H), 0.0), shininess);
+    vec3 specular = specularStrength * spec * lightColor;
+
+    vec3 result = (ambient + diffuse + specular) * lightScale * baseColor;
+#else
+    vec3 result = baseColor;
+#endif
+
+    FragColor = vec4(result + emissive, 1.0);
+}
@@ -1,4 +1,8 @@
-#version 330 core
+#version 410 core
+
+// Pode ser linkado como programa separavel (GL_PROGRAM_SEPARABLE) e
+// partilhado por todos os fragment shaders procedurais: as saidas usam
+// locations explicitas e gl_PerVertex e redeclarado.
 
 // Posicao do vertice no model space
 layout (location = 1) in vec3 inPosition;
@@ -6,31 +10,56 @@ layout (location = 1) in vec3 inPosition;
 // Normal do vertice wm model space
 layout (location = 2) in vec3 inNormal;
 
+#ifdef TEXTURED
+// Coordenadas de textura (variantes TEXTURED)
+layout (location = 3) in vec2 inTexcoord;
+layout (location = 2) out vec2 exTexcoord;
+#endif
+
 // ------------------- OUT (para o fragment shader) --------------------
 
 // Posicao do vertice em coordenadas do mundo
-out vec3 exPosition;
+layout (location = 0) out vec3 exPosition;
 
 // Normal transformada para coordenadas do mundo
-out vec3 exNormal;
+layout (location = 1) out vec3 exNormal;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
 
+#ifdef INSTANCED
+// Matriz do modelo e material por instancia (mgl::Mesh::InstanceData)
+layout (location = 6) in mat4 inInstanceMatrix;
+layout (location = 10) in vec4 inInstanceMaterial;
+
+// ambientStrength, specularStrength, shininess
+layout (location = 3) flat out vec3 exMaterial;
+#else
 // Matriz de transformacao do modelo (escala, rotacao, translacao)
 uniform mat4 ModelMatrix;
+#endif
 
 // Bloco uniforme da camara 
-layout(std140) uniform Camera {
-    mat4 ViewMatrix;
-    mat4 ProjectionMatrix;
-};
+#include "camera.glsl"
 
 void main()
 {
+#ifdef INSTANCED
+    mat4 ModelMatrix = inInstanceMatrix;
+    exMaterial = inInstanceMaterial.xyz;
+#endif
+
     // Converter a posicao do vertice de model space para world space
     exPosition = vec3(ModelMatrix * vec4(inPosition, 1.0));
 
     // Calcular a normal em world space
     exNormal = mat3(transpose(inverse(ModelMatrix))) * inNormal;
 
+#ifdef TEXTURED
+    exTexcoord = inTexcoord;
+#endif
+
     // Posicao final do vertice em clip space
     gl_Position = ProjectionMatrix * ViewMatrix * vec4(exPosition, 1.0);
 }
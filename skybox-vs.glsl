@@ -3,10 +3,7 @@
 layout (location = 1) in vec3 inPosition;
 out vec3 TexCoords;
 
-layout(std140) uniform Camera {
-    mat4 ViewMatrix;
-    mat4 ProjectionMatrix;
-};
+#include "camera.glsl"
 
 void main()
 {